@@ -3,6 +3,8 @@
 DEBUG_LED=0
 CLEAN_BUILD=0
 BOARD="pico"  # default board
+TRANSPORT="USB_CDC"  # default host link
+ESTIMATOR="RANSAC"  # default degradation scalar estimator
 
 # Parse all arguments
 for arg in "$@"; do
@@ -18,6 +20,14 @@ for arg in "$@"; do
             BOARD="${arg#*=}"
             echo "🛠️  Target board set to '$BOARD'"
             ;;
+        --transport=*)
+            TRANSPORT="${arg#*=}"
+            echo "🔌 Transport set to '$TRANSPORT'"
+            ;;
+        --estimator=*)
+            ESTIMATOR="${arg#*=}"
+            echo "📈 Estimator set to '$ESTIMATOR'"
+            ;;
         *)
             echo "⚠️  Unknown argument: $arg"
             ;;
@@ -33,7 +43,7 @@ fi
 mkdir -p build
 cd build || exit 1
 
-cmake -G Ninja -DPICO_BOARD=${BOARD} -DDEBUG_LED=${DEBUG_LED} ..
+cmake -G Ninja -DPICO_BOARD=${BOARD} -DDEBUG_LED=${DEBUG_LED} -DVLP_TRANSPORT=${TRANSPORT} -DVLP_DEGRADATION_ESTIMATOR=${ESTIMATOR} ..
 ninja
 if [ $? -ne 0 ]; then
     echo "Build failed"
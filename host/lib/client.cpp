@@ -0,0 +1,236 @@
+#include "client.h"
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+
+namespace vlp
+{
+    uint8_t reply_type_for(uint8_t opcode)
+    {
+        switch (opcode)
+        {
+        case VLP_OP_CALIBRATE_SAMPLE:
+        case VLP_OP_PREDICT:
+        case VLP_OP_PREDICT_ADC12:
+        case VLP_OP_PREDICT_ADC16:
+            return VLP_RESPONSE_POSITION;
+        case VLP_OP_GET_SCALARS:
+            return VLP_RESPONSE_SCALARS;
+        case VLP_OP_GET_STATS:
+            return VLP_RESPONSE_TELEMETRY;
+        case VLP_OP_BATCH_PREDICT:
+        case VLP_OP_REPLAY_READ:
+            return VLP_RESPONSE_POSITIONS;
+        case VLP_OP_REPLAY_RUN:
+            return VLP_RESPONSE_REPLAY_STATS;
+        case VLP_OP_ECHO:
+            return VLP_RESPONSE_ECHO;
+        case VLP_OP_GET_ADC_CALIBRATION:
+            return VLP_RESPONSE_ADC_CALIBRATION;
+        default:
+            return VLP_RESPONSE_ACK;
+        }
+    }
+
+    std::array<uint8_t, VLP_ADC12_BYTES> pack_adc12(const uint16_t counts[VLP_LED_COUNT])
+    {
+        std::array<uint8_t, VLP_ADC12_BYTES> packed;
+        for (int i = 0; i < VLP_LED_COUNT; i += 2)
+        {
+            uint16_t a = counts[i] & 0x0FFF;
+            uint16_t b = counts[i + 1] & 0x0FFF;
+            uint8_t *p = &packed[i / 2 * 3];
+            p[0] = static_cast<uint8_t>(a);
+            p[1] = static_cast<uint8_t>(a >> 8 | (b & 0x0F) << 4);
+            p[2] = static_cast<uint8_t>(b >> 4);
+        }
+        return packed;
+    }
+
+    bool apply_scalars(const Notification &notification, float scalars[VLP_LED_COUNT])
+    {
+        const std::vector<uint8_t> &payload = notification.payload;
+        if (notification.type == VLP_RESPONSE_SCALARS)
+        {
+            if (payload.size() != VLP_LED_BYTES)
+                return false;
+            std::memcpy(scalars, payload.data(), VLP_LED_BYTES);
+            return true;
+        }
+
+        if (notification.type != VLP_RESPONSE_SCALAR_DELTA || payload.empty() ||
+            payload.size() != 1 + payload[0] * sizeof(VlpScalarDelta))
+            return false;
+
+        std::vector<VlpScalarDelta> deltas(payload[0]);
+        std::memcpy(deltas.data(), payload.data() + 1, deltas.size() * sizeof(VlpScalarDelta));
+        for (const VlpScalarDelta &delta : deltas)
+        {
+            if (delta.index >= VLP_LED_COUNT)
+                return false;
+        }
+        for (const VlpScalarDelta &delta : deltas)
+            scalars[delta.index] = delta.value;
+        return true;
+    }
+
+    Client::Client(int fd) : fd_(fd) {}
+
+    std::optional<uint8_t> Client::submit(uint8_t opcode, const void *payload, uint16_t len, uint8_t flags)
+    {
+        if (!can_submit() || pending_[next_seq_].active)
+            return std::nullopt;
+
+        uint8_t seq = next_seq_++;
+        uint8_t header[VLP_REQUEST_HEADER_SIZE] = {
+            opcode, flags, seq, static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>(len >> 8)};
+        tx_.insert(tx_.end(), header, header + sizeof(header));
+        const uint8_t *bytes = static_cast<const uint8_t *>(payload);
+        tx_.insert(tx_.end(), bytes, bytes + len);
+
+        pending_[seq] = {true, opcode, Clock::now()};
+        in_flight_++;
+        return seq;
+    }
+
+    std::optional<uint8_t> Client::submit_predict(const float leds[VLP_LED_COUNT], uint8_t flags)
+    {
+        return submit(VLP_OP_PREDICT, leds, VLP_LED_BYTES, flags);
+    }
+
+    std::optional<uint8_t> Client::submit_predict_adc(const uint16_t counts[VLP_LED_COUNT], bool wide, uint8_t flags)
+    {
+        if (wide)
+        {
+            uint8_t bytes[VLP_ADC16_BYTES];
+            for (int i = 0; i < VLP_LED_COUNT; i++)
+            {
+                bytes[2 * i] = static_cast<uint8_t>(counts[i]);
+                bytes[2 * i + 1] = static_cast<uint8_t>(counts[i] >> 8);
+            }
+            return submit(VLP_OP_PREDICT_ADC16, bytes, sizeof(bytes), flags);
+        }
+
+        auto packed = pack_adc12(counts);
+        return submit(VLP_OP_PREDICT_ADC12, packed.data(), static_cast<uint16_t>(packed.size()), flags);
+    }
+
+    std::optional<uint8_t> Client::submit_batch(const float *frames, int count, uint8_t flags)
+    {
+        if (count < 1 || count > VLP_MAX_BATCH)
+            return std::nullopt;
+        return submit(VLP_OP_BATCH_PREDICT, frames, static_cast<uint16_t>(count * VLP_LED_BYTES), flags);
+    }
+
+    bool Client::poll()
+    {
+        while (!tx_.empty())
+        {
+            ssize_t written = ::write(fd_, tx_.data(), tx_.size());
+            if (written < 0)
+            {
+                if (errno == EAGAIN || errno == EINTR)
+                    break;
+                return false;
+            }
+            tx_.erase(tx_.begin(), tx_.begin() + written);
+        }
+
+        uint8_t buffer[4096];
+        while (true)
+        {
+            ssize_t got = ::read(fd_, buffer, sizeof(buffer));
+            if (got < 0)
+            {
+                if (errno == EAGAIN || errno == EINTR)
+                    break;
+                return false;
+            }
+            if (got == 0)
+                break; // Raw ttys with VMIN = 0 report "no data" this way
+            rx_.insert(rx_.end(), buffer, buffer + got);
+        }
+
+        parse_replies();
+        return true;
+    }
+
+    bool Client::wait(int timeout_ms)
+    {
+        pollfd pfd = {fd_, static_cast<short>(POLLIN | (tx_.empty() ? 0 : POLLOUT)), 0};
+        if (::poll(&pfd, 1, timeout_ms) < 0 && errno != EINTR)
+            return false;
+        return poll();
+    }
+
+    void Client::parse_replies()
+    {
+        size_t offset = 0;
+        while (rx_.size() - offset >= VLP_RESPONSE_HEADER_SIZE)
+        {
+            const uint8_t *header = &rx_[offset];
+            uint16_t len = static_cast<uint16_t>(header[3] | (header[4] << 8));
+            if (rx_.size() - offset < static_cast<size_t>(VLP_RESPONSE_HEADER_SIZE + len))
+                break;
+
+            const uint8_t *payload = header + VLP_RESPONSE_HEADER_SIZE;
+            uint8_t type = header[0] & ~(VLP_RESPONSE_TIMESTAMPED | VLP_RESPONSE_UNSOLICITED);
+            uint8_t seq = header[1];
+            last_credits_ = header[2];
+            offset += VLP_RESPONSE_HEADER_SIZE + len;
+
+            Pending &request = pending_[seq];
+            // Unsolicited frames reuse request seqs, only the type bit tells them apart. ERROR
+            // answers anything, and so does ECHO when the device is in loopback mode
+            bool answers = !(header[0] & VLP_RESPONSE_UNSOLICITED) && request.active &&
+                           (type == VLP_RESPONSE_ERROR || type == VLP_RESPONSE_ECHO ||
+                            type == reply_type_for(request.opcode));
+            if (!answers)
+            {
+                notifications_.push_back({type, seq, std::vector<uint8_t>(payload, payload + len)});
+                continue;
+            }
+
+            Completion completion;
+            completion.opcode = request.opcode;
+            completion.seq = seq;
+            completion.type = type;
+            completion.credits = header[2];
+            completion.submitted = request.submitted;
+            completion.completed = Clock::now();
+            if ((header[0] & VLP_RESPONSE_TIMESTAMPED) && len >= sizeof(VlpTimestamps))
+            {
+                VlpTimestamps timestamps;
+                len -= sizeof(VlpTimestamps);
+                std::memcpy(&timestamps, payload + len, sizeof(timestamps));
+                completion.timestamps = timestamps;
+            }
+            completion.payload.assign(payload, payload + len);
+            completions_.push_back(std::move(completion));
+
+            request.active = false;
+            in_flight_--;
+        }
+        rx_.erase(rx_.begin(), rx_.begin() + offset);
+    }
+
+    bool Client::complete(Completion &out)
+    {
+        if (completions_.empty())
+            return false;
+        out = std::move(completions_.front());
+        completions_.pop_front();
+        return true;
+    }
+
+    bool Client::notification(Notification &out)
+    {
+        if (notifications_.empty())
+            return false;
+        out = std::move(notifications_.front());
+        notifications_.pop_front();
+        return true;
+    }
+} // namespace vlp
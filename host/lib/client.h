@@ -0,0 +1,142 @@
+#ifndef VLP_CLIENT_H
+#define VLP_CLIENT_H
+
+#include "protocol.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <vector>
+
+namespace vlp
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief A reply matched to the request that caused it.
+     */
+    struct Completion
+    {
+        uint8_t opcode;
+        uint8_t seq;
+        uint8_t type; // VlpResponseType without the timestamp bit
+        uint8_t credits;
+        std::vector<uint8_t> payload; // Without the timestamp trailer
+        std::optional<VlpTimestamps> timestamps;
+        Clock::time_point submitted;
+        Clock::time_point completed;
+    };
+
+    /**
+     * @brief A frame that does not answer a request, e.g. periodic telemetry
+     * or the scalars sent after a recalibration.
+     */
+    struct Notification
+    {
+        uint8_t type; // VlpResponseType without the unsolicited bit
+        uint8_t seq;  // The CALIBRATE_SAMPLE behind SCALARS or SCALAR_DELTA, else 0
+        std::vector<uint8_t> payload;
+    };
+
+    /**
+     * @brief Non-blocking, pipelined client for the VLP wire protocol.
+     *
+     * submit() only buffers the request, poll() moves bytes in both directions
+     * without blocking and reassembles replies, complete() hands them out.
+     * At most VLP_MAX_OUTSTANDING requests are in flight at any time, which
+     * is what the device buffers. The client does not own the fd.
+     */
+    class Client
+    {
+    public:
+        explicit Client(int fd);
+
+        /**
+         * @brief Queues a request if a credit is available.
+         *
+         * @return The sequence number, or nothing if the window is full.
+         */
+        std::optional<uint8_t> submit(uint8_t opcode, const void *payload, uint16_t len, uint8_t flags = 0);
+
+        std::optional<uint8_t> submit_predict(const float leds[VLP_LED_COUNT], uint8_t flags = 0);
+
+        /**
+         * @brief Queues raw ADC counts, packed to 12 bits unless wide is set.
+         *
+         * Counts above 4095 are truncated when packing to 12 bits.
+         */
+        std::optional<uint8_t> submit_predict_adc(const uint16_t counts[VLP_LED_COUNT], bool wide = false,
+                                                  uint8_t flags = 0);
+
+        /**
+         * @brief Queues up to VLP_MAX_BATCH frames as one BATCH_PREDICT.
+         */
+        std::optional<uint8_t> submit_batch(const float *frames, int count, uint8_t flags = 0);
+
+        /**
+         * @brief Writes pending request bytes and parses received replies.
+         *
+         * @return false if the fd reported an error or end of file.
+         */
+        bool poll();
+
+        /**
+         * @brief Blocks in poll(2) for up to timeout_ms, then calls poll().
+         */
+        bool wait(int timeout_ms);
+
+        bool complete(Completion &out);
+
+        bool notification(Notification &out);
+
+        bool can_submit() const { return in_flight_ < VLP_MAX_OUTSTANDING; }
+        int in_flight() const { return in_flight_; }
+        uint8_t last_credits() const { return last_credits_; }
+        int fd() const { return fd_; }
+
+    private:
+        struct Pending
+        {
+            bool active = false;
+            uint8_t opcode = 0;
+            Clock::time_point submitted;
+        };
+
+        void parse_replies();
+
+        int fd_;
+        uint8_t next_seq_ = 0;
+        int in_flight_ = 0;
+        uint8_t last_credits_ = VLP_MAX_OUTSTANDING;
+
+        std::array<Pending, 256> pending_{};
+        std::vector<uint8_t> tx_;
+        std::vector<uint8_t> rx_;
+        std::deque<Completion> completions_;
+        std::deque<Notification> notifications_;
+    };
+
+    /**
+     * @brief The reply type that answers a request with the given opcode.
+     *
+     * ERROR answers any opcode, as does ECHO while the device is in loopback mode.
+     */
+    uint8_t reply_type_for(uint8_t opcode);
+
+    /**
+     * @brief Packs 12-bit ADC counts in the PREDICT_ADC12 layout.
+     */
+    std::array<uint8_t, VLP_ADC12_BYTES> pack_adc12(const uint16_t counts[VLP_LED_COUNT]);
+
+    /**
+     * @brief Applies a SCALARS or SCALAR_DELTA notification to the host's copy.
+     *
+     * @return false if the payload is malformed, scalars are left untouched then.
+     */
+    bool apply_scalars(const Notification &notification, float scalars[VLP_LED_COUNT]);
+} // namespace vlp
+
+#endif // VLP_CLIENT_H
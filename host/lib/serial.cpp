@@ -0,0 +1,60 @@
+#include "serial.h"
+
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace vlp
+{
+    static speed_t to_speed(int baud)
+    {
+        switch (baud)
+        {
+        case 115200:
+            return B115200;
+        case 230400:
+            return B230400;
+        case 460800:
+            return B460800;
+        case 921600:
+            return B921600;
+        case 1000000:
+            return B1000000;
+        case 2000000:
+            return B2000000;
+        case 3000000:
+            return B3000000;
+        default:
+            return B115200;
+        }
+    }
+
+    bool make_raw(int fd, int baud)
+    {
+        termios tty;
+        if (tcgetattr(fd, &tty) != 0)
+            return false;
+
+        cfmakeraw(&tty);
+        cfsetispeed(&tty, to_speed(baud));
+        cfsetospeed(&tty, to_speed(baud));
+        tty.c_cflag |= CLOCAL | CREAD;
+        tty.c_cc[VMIN] = 0;
+        tty.c_cc[VTIME] = 0;
+        return tcsetattr(fd, TCSANOW, &tty) == 0;
+    }
+
+    int open_serial(const std::string &path, int baud)
+    {
+        int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+            return -1;
+
+        if (!make_raw(fd, baud))
+        {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+} // namespace vlp
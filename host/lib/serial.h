@@ -0,0 +1,23 @@
+#ifndef VLP_SERIAL_H
+#define VLP_SERIAL_H
+
+#include <string>
+
+namespace vlp
+{
+    /**
+     * @brief Opens a serial device (or pty) in raw, non-blocking mode.
+     *
+     * @param path Device path, e.g. /dev/ttyACM0.
+     * @param baud Line speed, ignored by USB CDC but used by the UART transport.
+     * @return The file descriptor, or -1 with errno set.
+     */
+    int open_serial(const std::string &path, int baud = 3000000);
+
+    /**
+     * @brief Puts an already open terminal fd into raw mode.
+     */
+    bool make_raw(int fd, int baud);
+} // namespace vlp
+
+#endif // VLP_SERIAL_H
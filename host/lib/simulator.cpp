@@ -0,0 +1,225 @@
+#include "simulator.h"
+
+#include "serial.h"
+
+extern "C"
+{
+#include "parser.h"
+}
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
+
+namespace vlp
+{
+    namespace
+    {
+        uint64_t now_us()
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        void centroid(const float *leds, float *x, float *y)
+        {
+            float sum = 0.0f, sx = 0.0f, sy = 0.0f;
+            for (int i = 0; i < VLP_LED_COUNT; i++)
+            {
+                float w = leds[i] > 0.0f ? leds[i] : 0.0f;
+                sx += w * (25.0f + 50.0f * (i % 6));
+                sy += w * (25.0f + 50.0f * (i / 6));
+                sum += w;
+            }
+            *x = sum > 0.0f ? sx / sum : NAN;
+            *y = sum > 0.0f ? sy / sum : NAN;
+        }
+
+        void write_all(int fd, const std::vector<uint8_t> &bytes)
+        {
+            size_t offset = 0;
+            while (offset < bytes.size())
+            {
+                ssize_t written = ::write(fd, bytes.data() + offset, bytes.size() - offset);
+                if (written < 0)
+                {
+                    if (errno == EAGAIN || errno == EINTR)
+                    {
+                        pollfd pfd = {fd, POLLOUT, 0};
+                        ::poll(&pfd, 1, 10);
+                        continue;
+                    }
+                    return;
+                }
+                offset += written;
+            }
+        }
+    } // namespace
+
+    SimulatedDevice::SimulatedDevice(std::chrono::microseconds inference_time)
+        : inference_time_(inference_time) {}
+
+    SimulatedDevice::~SimulatedDevice()
+    {
+        stop();
+    }
+
+    bool SimulatedDevice::start()
+    {
+        master_ = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_ < 0 || grantpt(master_) != 0 || unlockpt(master_) != 0)
+            return false;
+
+        path_ = ptsname(master_);
+        slave_ = open(path_.c_str(), O_RDWR | O_NOCTTY);
+        if (slave_ < 0 || !make_raw(slave_, 3000000))
+            return false;
+
+        fcntl(master_, F_SETFL, fcntl(master_, F_GETFL) | O_NONBLOCK);
+        running_ = true;
+        thread_ = std::thread(&SimulatedDevice::run, this);
+        return true;
+    }
+
+    void SimulatedDevice::stop()
+    {
+        running_ = false;
+        if (thread_.joinable())
+            thread_.join();
+        if (slave_ >= 0)
+            close(slave_);
+        if (master_ >= 0)
+            close(master_);
+        slave_ = master_ = -1;
+    }
+
+    void SimulatedDevice::run()
+    {
+        PacketParser parser;
+        parser_init(&parser);
+
+        std::deque<IncomingPacket> queue;
+        IncomingPacket incoming;
+        std::vector<uint8_t> rx;
+
+        while (running_)
+        {
+            pollfd pfd = {master_, POLLIN, 0};
+            ::poll(&pfd, 1, queue.empty() ? 5 : 0);
+
+            uint8_t buffer[4096];
+            ssize_t got;
+            while ((got = ::read(master_, buffer, sizeof(buffer))) > 0)
+                rx.insert(rx.end(), buffer, buffer + got);
+
+            // Only take in what the device would have room for
+            size_t offset = 0;
+            while (offset < rx.size() && queue.size() < VLP_MAX_OUTSTANDING)
+            {
+                size_t consumed;
+                ParserResult result = parser_feed(&parser, rx.data() + offset, rx.size() - offset, &consumed, &incoming);
+                offset += consumed;
+                if (result != PARSER_INCOMPLETE)
+                {
+                    incoming.arrival_us = now_us();
+                    if (result == PARSER_ERROR)
+                        incoming.opcode = 0xFF; // Answered with an error below
+                    queue.push_back(incoming);
+                }
+            }
+            rx.erase(rx.begin(), rx.begin() + offset);
+
+            if (queue.empty())
+                continue;
+
+            IncomingPacket request = queue.front();
+            queue.pop_front();
+
+            std::vector<uint8_t> payload;
+            uint8_t type = VLP_RESPONSE_ACK;
+            uint64_t inference_start = 0, inference_end = 0;
+            auto infer = [&](int frames)
+            {
+                inference_start = now_us();
+                std::this_thread::sleep_for(inference_time_ * frames);
+                inference_end = now_us();
+                const float *leds = reinterpret_cast<const float *>(request.payload);
+                for (int i = 0; i < frames; i++)
+                {
+                    float xy[2];
+                    centroid(&leds[i * VLP_LED_COUNT], &xy[0], &xy[1]);
+                    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(xy);
+                    payload.insert(payload.end(), bytes, bytes + sizeof(xy));
+                }
+            };
+
+            bool frames_ok = request.len > 0 && request.len % VLP_LED_BYTES == 0;
+            switch (request.opcode)
+            {
+            case VLP_OP_PREDICT:
+            case VLP_OP_CALIBRATE_SAMPLE:
+            case VLP_OP_BATCH_PREDICT:
+                if (!frames_ok || (request.opcode != VLP_OP_BATCH_PREDICT && request.len != VLP_LED_BYTES))
+                {
+                    type = VLP_RESPONSE_ERROR;
+                    payload.assign(1, VLP_ERROR_BAD_LENGTH);
+                    break;
+                }
+                type = request.opcode == VLP_OP_BATCH_PREDICT ? VLP_RESPONSE_POSITIONS : VLP_RESPONSE_POSITION;
+                infer(request.len / VLP_LED_BYTES);
+                break;
+            case VLP_OP_GET_SCALARS:
+                type = VLP_RESPONSE_SCALARS;
+                for (int i = 0; i < VLP_LED_COUNT; i++)
+                {
+                    float one = 1.0f;
+                    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&one);
+                    payload.insert(payload.end(), bytes, bytes + sizeof(one));
+                }
+                break;
+            case VLP_OP_ECHO:
+                type = VLP_RESPONSE_ECHO;
+                payload.assign(request.payload, request.payload + request.len);
+                break;
+            case VLP_OP_GET_STATS:
+                type = VLP_RESPONSE_TELEMETRY;
+                payload.resize(sizeof(VlpTelemetryReport));
+                break;
+            case VLP_OP_SET_SCALARS:
+            case VLP_OP_SET_PARAM:
+            case VLP_OP_RESET_BUFFER:
+                break;
+            case 0xFF:
+                type = VLP_RESPONSE_ERROR;
+                payload.assign(1, VLP_ERROR_BAD_LENGTH);
+                break;
+            default:
+                type = VLP_RESPONSE_ERROR;
+                payload.assign(1, VLP_ERROR_UNKNOWN_OPCODE);
+                break;
+            }
+
+            if (request.flags & VLP_FLAG_TIMESTAMPS)
+            {
+                type |= VLP_RESPONSE_TIMESTAMPED;
+                VlpTimestamps timestamps = {request.arrival_us, inference_start, inference_end, now_us()};
+                const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&timestamps);
+                payload.insert(payload.end(), bytes, bytes + sizeof(timestamps));
+            }
+
+            uint16_t len = static_cast<uint16_t>(payload.size());
+            std::vector<uint8_t> frame = {
+                type, request.seq, static_cast<uint8_t>(VLP_MAX_OUTSTANDING - queue.size()),
+                static_cast<uint8_t>(len & 0xFF), static_cast<uint8_t>(len >> 8)};
+            frame.insert(frame.end(), payload.begin(), payload.end());
+            write_all(master_, frame);
+        }
+    }
+} // namespace vlp
@@ -0,0 +1,50 @@
+#ifndef VLP_SIMULATOR_H
+#define VLP_SIMULATOR_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace vlp
+{
+    /**
+     * @brief A stand-in for the board behind a pseudo terminal.
+     *
+     * Speaks the same wire protocol using the firmware's own request parser,
+     * buffers up to VLP_MAX_OUTSTANDING requests and takes inference_time per
+     * frame. Positions are a weighted centroid over a 6 x 6 LED grid, good
+     * enough to exercise clients and load generators without hardware.
+     */
+    class SimulatedDevice
+    {
+    public:
+        explicit SimulatedDevice(std::chrono::microseconds inference_time = std::chrono::microseconds(800));
+        ~SimulatedDevice();
+
+        SimulatedDevice(const SimulatedDevice &) = delete;
+        SimulatedDevice &operator=(const SimulatedDevice &) = delete;
+
+        /**
+         * @brief Opens the pty and starts answering on a background thread.
+         */
+        bool start();
+
+        void stop();
+
+        // Path of the terminal side, open it with open_serial()
+        const std::string &path() const { return path_; }
+
+    private:
+        void run();
+
+        std::chrono::microseconds inference_time_;
+        int master_ = -1;
+        int slave_ = -1; // Held open so the master never sees a hangup
+        std::string path_;
+        std::thread thread_;
+        std::atomic<bool> running_{false};
+    };
+} // namespace vlp
+
+#endif // VLP_SIMULATOR_H
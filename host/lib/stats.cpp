@@ -0,0 +1,16 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace vlp
+{
+    double percentile(std::vector<double> &values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+        size_t index = static_cast<size_t>(p / 100.0 * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+} // namespace vlp
@@ -0,0 +1,20 @@
+#ifndef VLP_STATS_H
+#define VLP_STATS_H
+
+#include <vector>
+
+namespace vlp
+{
+    /**
+     * @brief Nearest-rank percentile of a set of samples.
+     *
+     * Partially reorders values, which is cheaper than sorting them for the
+     * few percentiles a report prints.
+     *
+     * @param p Percentile, 0..100.
+     * @return The sample at that rank, 0 if there are none.
+     */
+    double percentile(std::vector<double> &values, double p);
+} // namespace vlp
+
+#endif // VLP_STATS_H
@@ -0,0 +1,232 @@
+#include "usb_vendor.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/usbdevice_fs.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace vlp
+{
+    namespace
+    {
+        constexpr uint8_t DESCRIPTOR_INTERFACE = 4;
+        constexpr uint8_t DESCRIPTOR_ENDPOINT = 5;
+        constexpr uint8_t CLASS_VENDOR = 0xFF;
+        constexpr uint8_t TRANSFER_BULK = 2;
+        constexpr uint8_t ENDPOINT_IN = 0x80;
+
+        constexpr int RX_TIMEOUT_MS = 100; // Bounds how long close() waits for the RX thread
+        constexpr unsigned TX_TIMEOUT_MS = 1000;
+        constexpr size_t TRANSFER_SIZE = 16384;
+        // Kept queued on the IN endpoint, more than a full-speed frame carries
+        constexpr size_t RX_URBS = 32;
+
+        int bulk(int fd, unsigned endpoint, void *data, size_t len, unsigned timeout_ms)
+        {
+            usbdevfs_bulktransfer transfer = {};
+            transfer.ep = endpoint;
+            transfer.len = static_cast<unsigned>(len);
+            transfer.timeout = timeout_ms;
+            transfer.data = data;
+            return ::ioctl(fd, USBDEVFS_BULK, &transfer);
+        }
+    } // namespace
+
+    bool is_usbfs_path(const std::string &path)
+    {
+        return path.rfind("/dev/bus/usb/", 0) == 0;
+    }
+
+    UsbVendorLink::~UsbVendorLink()
+    {
+        close();
+    }
+
+    // Reading a usbfs node yields the device descriptor followed by the
+    // descriptors of every configuration
+    bool UsbVendorLink::find_interface()
+    {
+        std::vector<uint8_t> descriptors(4096);
+        ssize_t len = ::read(usb_fd_, descriptors.data(), descriptors.size());
+        if (len <= 0)
+            return false;
+
+        int candidate = -1;
+        unsigned in = 0, out = 0, in_packet = 0;
+        for (ssize_t offset = 0; offset + 2 <= len && descriptors[offset] > 0; offset += descriptors[offset])
+        {
+            const uint8_t *d = &descriptors[offset];
+            if (d[1] == DESCRIPTOR_INTERFACE && offset + 9 <= len)
+            {
+                if (candidate >= 0 && in && out)
+                    break; // The previous interface has everything
+                candidate = d[5] == CLASS_VENDOR ? d[2] : -1;
+                in = out = 0;
+            }
+            else if (d[1] == DESCRIPTOR_ENDPOINT && candidate >= 0 && offset + 7 <= len &&
+                     (d[3] & 0x03) == TRANSFER_BULK)
+            {
+                (d[2] & ENDPOINT_IN ? in : out) = d[2];
+                if (d[2] & ENDPOINT_IN)
+                    in_packet = (d[4] | d[5] << 8) & 0x7FF;
+            }
+        }
+
+        if (candidate < 0 || !in || !out || !in_packet)
+        {
+            errno = ENODEV;
+            return false;
+        }
+        interface_ = candidate;
+        ep_in_ = in;
+        ep_out_ = out;
+        packet_size_ = in_packet;
+        return true;
+    }
+
+    int UsbVendorLink::open(const std::string &path)
+    {
+        close();
+        usb_fd_ = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+        if (usb_fd_ < 0)
+            return -1;
+
+        int fds[2];
+        if (!find_interface() || ::ioctl(usb_fd_, USBDEVFS_CLAIMINTERFACE, &interface_) != 0 ||
+            ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            int error = errno;
+            close();
+            errno = error;
+            return -1;
+        }
+
+        relay_fd_ = fds[1];
+        ::fcntl(fds[0], F_SETFL, ::fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        running_ = true;
+        rx_thread_ = std::thread(&UsbVendorLink::rx_loop, this);
+        tx_thread_ = std::thread(&UsbVendorLink::tx_loop, this);
+        return fds[0];
+    }
+
+    void UsbVendorLink::close()
+    {
+        running_ = false;
+        if (relay_fd_ >= 0)
+            ::shutdown(relay_fd_, SHUT_RDWR); // Wakes the TX thread
+        if (rx_thread_.joinable())
+            rx_thread_.join();
+        if (tx_thread_.joinable())
+            tx_thread_.join();
+
+        if (relay_fd_ >= 0)
+            ::close(relay_fd_);
+        if (usb_fd_ >= 0)
+        {
+            if (interface_ >= 0)
+                ::ioctl(usb_fd_, USBDEVFS_RELEASEINTERFACE, &interface_);
+            ::close(usb_fd_);
+        }
+        relay_fd_ = usb_fd_ = interface_ = -1;
+    }
+
+    bool UsbVendorLink::submit_rx(usbdevfs_urb &urb, uint8_t *buffer)
+    {
+        urb = {};
+        urb.type = USBDEVFS_URB_TYPE_BULK;
+        urb.endpoint = static_cast<unsigned char>(ep_in_);
+        urb.buffer = buffer;
+        urb.buffer_length = static_cast<int>(packet_size_);
+        return ::ioctl(usb_fd_, USBDEVFS_SUBMITURB, &urb) == 0;
+    }
+
+    // A bulk IN transfer only ends early on a short packet and the firmware
+    // never sends a zero-length one, so a longer read would sit on a reply that
+    // ends on a packet boundary. Every URB asks for exactly one packet instead,
+    // and enough of them stay queued that the endpoint is never left idle.
+    void UsbVendorLink::rx_loop()
+    {
+        std::vector<usbdevfs_urb> urbs(RX_URBS);
+        std::vector<uint8_t> buffers(RX_URBS * packet_size_);
+        size_t queued = 0;
+        for (size_t i = 0; i < RX_URBS; i++)
+        {
+            if (submit_rx(urbs[i], &buffers[i * packet_size_]))
+                queued++;
+        }
+
+        bool forwarding = queued == RX_URBS;
+        while (running_ && forwarding)
+        {
+            pollfd ready = {usb_fd_, POLLOUT, 0};
+            if (::poll(&ready, 1, RX_TIMEOUT_MS) < 0 && errno != EINTR)
+                break;
+
+            usbdevfs_urb *urb;
+            while (forwarding && ::ioctl(usb_fd_, USBDEVFS_REAPURBNDELAY, &urb) == 0)
+            {
+                queued--;
+                if (urb->status != 0)
+                {
+                    forwarding = false; // Unplugged or stalled
+                    break;
+                }
+
+                auto *data = static_cast<uint8_t *>(urb->buffer);
+                for (int offset = 0; offset < urb->actual_length;)
+                {
+                    ssize_t written = ::send(relay_fd_, data + offset, urb->actual_length - offset, MSG_NOSIGNAL);
+                    if (written <= 0)
+                    {
+                        forwarding = false; // The client closed its end
+                        break;
+                    }
+                    offset += static_cast<int>(written);
+                }
+
+                if (!forwarding || !submit_rx(*urb, data))
+                {
+                    forwarding = false;
+                    break;
+                }
+                queued++;
+            }
+            if (forwarding && errno != EAGAIN)
+                break; // Unplugged
+        }
+
+        // Cancel and collect whatever is still queued before the buffers go
+        for (auto &urb : urbs)
+            ::ioctl(usb_fd_, USBDEVFS_DISCARDURB, &urb);
+        usbdevfs_urb *urb;
+        while (queued > 0)
+        {
+            if (::ioctl(usb_fd_, USBDEVFS_REAPURB, &urb) == 0)
+                queued--;
+            else if (errno != EINTR)
+                break; // Unplugged, the kernel has already given them up
+        }
+        ::shutdown(relay_fd_, SHUT_WR); // The client reads EOF
+    }
+
+    void UsbVendorLink::tx_loop()
+    {
+        std::vector<uint8_t> buffer(TRANSFER_SIZE);
+        while (running_)
+        {
+            ssize_t len = ::read(relay_fd_, buffer.data(), buffer.size());
+            if (len <= 0)
+                return; // Closed by the client or by close()
+
+            if (bulk(usb_fd_, ep_out_, buffer.data(), static_cast<size_t>(len), TX_TIMEOUT_MS) != len)
+            {
+                ::shutdown(relay_fd_, SHUT_RDWR);
+                return;
+            }
+        }
+    }
+} // namespace vlp
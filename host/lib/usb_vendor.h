@@ -0,0 +1,69 @@
+#ifndef VLP_USB_VENDOR_H
+#define VLP_USB_VENDOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+struct usbdevfs_urb;
+
+namespace vlp
+{
+    /**
+     * @brief True for a usbfs device node, e.g. /dev/bus/usb/001/007.
+     */
+    bool is_usbfs_path(const std::string &path);
+
+    /**
+     * @brief Host side of the USB_VENDOR transport.
+     *
+     * The vendor interface is not a tty, so it is opened through usbfs and its
+     * bulk endpoints are relayed to one end of a socket pair by two threads.
+     * The other end is a plain non-blocking fd that vlp::Client can use like a
+     * serial port. The relay adds a few microseconds per transfer, well below
+     * the 1 ms USB frame.
+     */
+    class UsbVendorLink
+    {
+    public:
+        UsbVendorLink() = default;
+        ~UsbVendorLink();
+
+        UsbVendorLink(const UsbVendorLink &) = delete;
+        UsbVendorLink &operator=(const UsbVendorLink &) = delete;
+
+        /**
+         * @brief Claims the first vendor-class interface with bulk IN and OUT
+         * endpoints and starts relaying.
+         *
+         * @param path The usbfs node of the board, needs read/write access.
+         * @return The fd to talk to the board through, owned by the caller,
+         * or -1 with errno set.
+         */
+        int open(const std::string &path);
+
+        /**
+         * @brief Stops the relay and releases the interface.
+         */
+        void close();
+
+    private:
+        bool find_interface();
+        bool submit_rx(usbdevfs_urb &urb, uint8_t *buffer);
+        void rx_loop();
+        void tx_loop();
+
+        int usb_fd_ = -1;
+        int relay_fd_ = -1; // Device side of the socket pair
+        int interface_ = -1;
+        unsigned ep_in_ = 0;
+        unsigned ep_out_ = 0;
+        unsigned packet_size_ = 0; // wMaxPacketSize of the IN endpoint
+        std::thread rx_thread_;
+        std::thread tx_thread_;
+        std::atomic<bool> running_{false};
+    };
+} // namespace vlp
+
+#endif // VLP_USB_VENDOR_H
@@ -0,0 +1,158 @@
+// Feeds a random stream of request frames through the firmware's parser in
+// randomly sized chunks and checks every frame comes out exactly once, intact
+// and in order, whatever the chunk boundaries.
+
+#include "parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FRAMES 3000
+#define ROUNDS 20
+#define MAX_CHUNK 300
+
+typedef struct ExpectedFrame
+{
+    uint8_t opcode;
+    uint8_t flags;
+    uint8_t seq;
+    uint16_t len;
+    size_t payload_offset; // Into the stream
+} ExpectedFrame;
+
+static ExpectedFrame expected[FRAMES];
+static uint8_t stream[FRAMES * (VLP_REQUEST_HEADER_SIZE + 2 * VLP_MAX_PAYLOAD)];
+static IncomingPacket packet;
+
+static uint16_t random_len(void)
+{
+    switch (rand() % 8)
+    {
+    case 0:
+        return 0; // Empty payload
+    case 1:
+        return VLP_MAX_PAYLOAD;
+    case 2:
+        return (uint16_t)(VLP_MAX_PAYLOAD + 1 + rand() % VLP_MAX_PAYLOAD); // Discarded
+    default:
+        return (uint16_t)(rand() % (VLP_MAX_PAYLOAD + 1));
+    }
+}
+
+static size_t build_stream(void)
+{
+    size_t size = 0;
+    for (int i = 0; i < FRAMES; i++)
+    {
+        ExpectedFrame *frame = &expected[i];
+        frame->opcode = (uint8_t)rand();
+        frame->flags = (uint8_t)rand();
+        frame->seq = (uint8_t)i;
+        frame->len = random_len();
+
+        uint8_t *header = &stream[size];
+        header[0] = frame->opcode;
+        header[1] = frame->flags;
+        header[2] = frame->seq;
+        header[3] = (uint8_t)(frame->len & 0xFF);
+        header[4] = (uint8_t)(frame->len >> 8);
+        size += VLP_REQUEST_HEADER_SIZE;
+
+        frame->payload_offset = size;
+        for (int j = 0; j < frame->len; j++)
+        {
+            stream[size++] = (uint8_t)rand();
+        }
+    }
+    return size;
+}
+
+static int check_frame(int index, ParserResult result)
+{
+    const ExpectedFrame *frame = &expected[index];
+    bool oversized = frame->len > VLP_MAX_PAYLOAD;
+    if (result != (oversized ? PARSER_ERROR : PARSER_COMPLETE))
+    {
+        printf("frame %d: result %d, len %u\n", index, result, frame->len);
+        return 1;
+    }
+    if (packet.opcode != frame->opcode || packet.flags != frame->flags || packet.seq != frame->seq ||
+        packet.len != frame->len)
+    {
+        printf("frame %d: header mismatch\n", index);
+        return 1;
+    }
+    if (!oversized && memcmp(packet.payload, &stream[frame->payload_offset], frame->len) != 0)
+    {
+        printf("frame %d: payload mismatch\n", index);
+        return 1;
+    }
+    return 0;
+}
+
+// Feeds the stream in chunks of 1..max_chunk bytes, a chunk may end anywhere,
+// including inside a header and right after one
+static int run(size_t size, int max_chunk)
+{
+    PacketParser parser;
+    parser_init(&parser);
+
+    int next = 0;
+    size_t offset = 0;
+    while (offset < size)
+    {
+        size_t chunk = 1 + (size_t)rand() % max_chunk;
+        if (chunk > size - offset)
+        {
+            chunk = size - offset;
+        }
+
+        // Frames back to back in one chunk are handed out one per call
+        size_t used = 0;
+        while (used < chunk)
+        {
+            size_t consumed;
+            ParserResult result = parser_feed(&parser, &stream[offset + used], chunk - used, &consumed, &packet);
+            used += consumed;
+            if (result == PARSER_INCOMPLETE)
+            {
+                break;
+            }
+            if (next == FRAMES || check_frame(next++, result))
+            {
+                return 1;
+            }
+        }
+        if (used != chunk)
+        {
+            printf("chunk at %zu: %zu of %zu bytes consumed\n", offset, used, chunk);
+            return 1;
+        }
+        offset += chunk;
+    }
+
+    if (next != FRAMES || parser_in_frame(&parser))
+    {
+        printf("%d of %d frames parsed\n", next, FRAMES);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    srand(1);
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        size_t size = build_stream();
+        int max_chunk = round % 2 == 0 ? VLP_REQUEST_HEADER_SIZE : MAX_CHUNK;
+        if (run(size, max_chunk))
+        {
+            printf("round %d failed\n", round);
+            return 1;
+        }
+    }
+    printf("%d frames parsed in %d rounds\n", FRAMES * ROUNDS, ROUNDS);
+    return 0;
+}
@@ -0,0 +1,134 @@
+// Measures the raw link by sweeping ECHO payload sizes and pipeline depths
+// through the same IO path the inference requests use.
+
+#include "client.h"
+#include "serial.h"
+#include "simulator.h"
+#include "stats.h"
+#include "usb_vendor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+    struct Options
+    {
+        std::string device;
+        bool simulate = false;
+        int baud = 3000000;
+        double seconds = 1.0; // Per payload size and depth
+    };
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s (--device PATH | --sim) [--baud B] [--seconds S]\n"
+                     "PATH is a tty, or a /dev/bus/usb/BBB/DDD node for the USB_VENDOR transport\n",
+                     name);
+        std::exit(1);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--device" && i + 1 < argc)
+            options.device = argv[++i];
+        else if (arg == "--sim")
+            options.simulate = true;
+        else if (arg == "--baud" && i + 1 < argc)
+            options.baud = std::stoi(argv[++i]);
+        else if (arg == "--seconds" && i + 1 < argc)
+            options.seconds = std::stod(argv[++i]);
+        else
+            usage(argv[0]);
+    }
+    if (options.device.empty() == !options.simulate)
+        usage(argv[0]);
+
+    vlp::SimulatedDevice simulator(microseconds(0));
+    std::string path = options.device;
+    if (options.simulate)
+    {
+        if (!simulator.start())
+        {
+            std::perror("Failed to start simulated device");
+            return 1;
+        }
+        path = simulator.path();
+    }
+
+    // A usbfs node is the USB_VENDOR transport, anything else a tty
+    vlp::UsbVendorLink usb;
+    int fd = vlp::is_usbfs_path(path) ? usb.open(path) : vlp::open_serial(path, options.baud);
+    if (fd < 0)
+    {
+        std::perror(path.c_str());
+        return 1;
+    }
+    vlp::Client client(fd);
+
+    const int sizes[] = {0, 16, 64, VLP_LED_BYTES, 256, 512, 1024, VLP_MAX_PAYLOAD};
+    const int depths[] = {1, 2, 4, VLP_MAX_OUTSTANDING};
+    std::vector<uint8_t> payload(VLP_MAX_PAYLOAD);
+    for (size_t i = 0; i < payload.size(); i++)
+        payload[i] = static_cast<uint8_t>(i);
+
+    std::printf("%8s%6s%12s%12s%10s%10s%10s\n", "payload", "depth", "req/s", "bytes/s", "p50 us", "p99 us", "max us");
+    for (int size : sizes)
+    {
+        for (int depth : depths)
+        {
+            std::vector<double> rtt_us;
+            long bytes = 0;
+            auto start = vlp::Clock::now();
+            auto end = start + duration_cast<vlp::Clock::duration>(duration<double>(options.seconds));
+
+            while (vlp::Clock::now() < end || client.in_flight() > 0)
+            {
+                while (vlp::Clock::now() < end && client.in_flight() < depth)
+                {
+                    if (!client.submit(VLP_OP_ECHO, payload.data(), static_cast<uint16_t>(size)))
+                        break;
+                }
+
+                if (!client.wait(1))
+                {
+                    std::fprintf(stderr, "Device link failed\n");
+                    return 1;
+                }
+
+                vlp::Completion completion;
+                while (client.complete(completion))
+                {
+                    rtt_us.push_back(duration<double, std::micro>(completion.completed - completion.submitted).count());
+                    // Both directions carry the payload plus a header
+                    bytes += 2 * size + VLP_REQUEST_HEADER_SIZE + VLP_RESPONSE_HEADER_SIZE;
+                }
+
+                vlp::Notification notification;
+                while (client.notification(notification))
+                {
+                }
+            }
+
+            double elapsed = duration<double>(vlp::Clock::now() - start).count();
+            double max = rtt_us.empty() ? 0.0 : *std::max_element(rtt_us.begin(), rtt_us.end());
+            std::printf("%8d%6d%12.1f%12.0f%10.1f%10.1f%10.1f\n", size, depth, rtt_us.size() / elapsed,
+                        bytes / elapsed, vlp::percentile(rtt_us, 50), vlp::percentile(rtt_us, 99), max);
+        }
+    }
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,205 @@
+// Drives a VLP device (or a simulated one on a pty) at a target request rate
+// and reports throughput and latency percentiles.
+
+#include "client.h"
+#include "serial.h"
+#include "simulator.h"
+#include "stats.h"
+#include "usb_vendor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+    struct Options
+    {
+        std::string device;
+        bool simulate = false;
+        double rate = 0.0; // Requests per second, 0 keeps the window full
+        double duration = 10.0;
+        int batch = 1;
+        int baud = 3000000;
+        bool timestamps = false;
+    };
+
+    void usage(const char *name)
+    {
+        std::fprintf(stderr,
+                     "Usage: %s (--device PATH | --sim) [--rate R] [--duration S] [--batch N]\n"
+                     "          [--baud B] [--timestamps]\n"
+                     "PATH is a tty, or a /dev/bus/usb/BBB/DDD node for the USB_VENDOR transport\n",
+                     name);
+        std::exit(1);
+    }
+
+    Options parse_args(int argc, char **argv)
+    {
+        Options options;
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            auto value = [&]()
+            {
+                if (i + 1 >= argc)
+                    usage(argv[0]);
+                return std::string(argv[++i]);
+            };
+
+            if (arg == "--device")
+                options.device = value();
+            else if (arg == "--sim")
+                options.simulate = true;
+            else if (arg == "--rate")
+                options.rate = std::stod(value());
+            else if (arg == "--duration")
+                options.duration = std::stod(value());
+            else if (arg == "--batch")
+                options.batch = std::stoi(value());
+            else if (arg == "--baud")
+                options.baud = std::stoi(value());
+            else if (arg == "--timestamps")
+                options.timestamps = true;
+            else
+                usage(argv[0]);
+        }
+
+        if (options.device.empty() == !options.simulate || options.batch < 1 || options.batch > VLP_MAX_BATCH)
+            usage(argv[0]);
+        return options;
+    }
+
+    void report(const char *name, std::vector<double> &values)
+    {
+        double max = values.empty() ? 0.0 : *std::max_element(values.begin(), values.end());
+        std::printf("%-12s%10.1f%10.1f%10.1f%10.1f%10.1f\n", name,
+                    vlp::percentile(values, 50), vlp::percentile(values, 90), vlp::percentile(values, 99),
+                    vlp::percentile(values, 99.9), max);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options = parse_args(argc, argv);
+
+    vlp::SimulatedDevice simulator;
+    std::string path = options.device;
+    if (options.simulate)
+    {
+        if (!simulator.start())
+        {
+            std::perror("Failed to start simulated device");
+            return 1;
+        }
+        path = simulator.path();
+    }
+
+    // A usbfs node is the USB_VENDOR transport, anything else a tty
+    vlp::UsbVendorLink usb;
+    int fd = vlp::is_usbfs_path(path) ? usb.open(path) : vlp::open_serial(path, options.baud);
+    if (fd < 0)
+    {
+        std::perror(path.c_str());
+        return 1;
+    }
+    vlp::Client client(fd);
+
+    // Random RSS frames, the content does not change the device's work
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> rss(0.0f, 1.0f);
+    std::vector<float> frames(VLP_LED_COUNT * VLP_MAX_BATCH);
+    for (float &value : frames)
+        value = rss(rng);
+
+    uint8_t flags = options.timestamps ? VLP_FLAG_TIMESTAMPS : 0;
+    auto interval = options.rate > 0.0 ? duration_cast<vlp::Clock::duration>(duration<double>(1.0 / options.rate))
+                                       : vlp::Clock::duration::zero();
+
+    // Latency is measured from when a request was due, not when a credit
+    // finally allowed it out, so a saturated device shows up as latency
+    std::vector<vlp::Clock::time_point> intended(256);
+    std::vector<double> latency_us, service_us, queue_us, inference_us, link_us;
+
+    auto start = vlp::Clock::now();
+    auto end = start + duration_cast<vlp::Clock::duration>(duration<double>(options.duration));
+    auto next_due = start;
+    long submitted = 0, completed = 0, errors = 0, frames_done = 0, notifications = 0;
+
+    while (true)
+    {
+        auto now = vlp::Clock::now();
+        bool sending = now < end;
+
+        while (sending && now >= next_due && client.can_submit())
+        {
+            auto seq = options.batch == 1 ? client.submit_predict(frames.data(), flags)
+                                          : client.submit_batch(frames.data(), options.batch, flags);
+            if (!seq)
+                break;
+            intended[*seq] = interval == vlp::Clock::duration::zero() ? now : next_due;
+            next_due += interval;
+            submitted++;
+        }
+
+        if (!sending && client.in_flight() == 0)
+            break;
+
+        if (!client.wait(1))
+        {
+            std::fprintf(stderr, "Device link failed\n");
+            return 1;
+        }
+
+        vlp::Completion completion;
+        while (client.complete(completion))
+        {
+            completed++;
+            if (completion.type == VLP_RESPONSE_ERROR)
+            {
+                errors++;
+                continue;
+            }
+            frames_done += options.batch;
+            latency_us.push_back(duration<double, std::micro>(completion.completed - intended[completion.seq]).count());
+            service_us.push_back(duration<double, std::micro>(completion.completed - completion.submitted).count());
+
+            if (completion.timestamps)
+            {
+                const VlpTimestamps &ts = *completion.timestamps;
+                double device = static_cast<double>(ts.enqueue_us - ts.arrival_us);
+                queue_us.push_back(static_cast<double>(ts.inference_start_us - ts.arrival_us));
+                inference_us.push_back(static_cast<double>(ts.inference_end_us - ts.inference_start_us));
+                link_us.push_back(service_us.back() - device);
+            }
+        }
+
+        vlp::Notification notification;
+        while (client.notification(notification))
+            notifications++;
+    }
+
+    double elapsed = duration<double>(vlp::Clock::now() - start).count();
+    std::printf("%ld requests submitted, %ld completed, %ld errors, %ld notifications in %.2f s\n",
+                submitted, completed, errors, notifications, elapsed);
+    std::printf("throughput: %.1f requests/s, %.1f frames/s\n", completed / elapsed, frames_done / elapsed);
+    std::printf("%-12s%10s%10s%10s%10s%10s\n", "latency us", "p50", "p90", "p99", "p99.9", "max");
+    report("total", latency_us);
+    report("service", service_us);
+    if (!queue_us.empty())
+    {
+        report("dev queue", queue_us);
+        report("dev infer", inference_us);
+        report("link", link_us);
+    }
+
+    close(fd);
+    return 0;
+}
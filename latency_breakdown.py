@@ -0,0 +1,101 @@
+import os
+import struct
+import time
+
+if len(os.sys.argv) < 2:
+    print("Usage: python latency_breakdown.py <serial_port> [count] [depth] [frames.csv]")
+    exit(1)
+
+PORT = os.sys.argv[1]
+COUNT = int(os.sys.argv[2]) if len(os.sys.argv) > 2 else 1000
+DEPTH = int(os.sys.argv[3]) if len(os.sys.argv) > 3 else 1  # Requests kept in flight, at most 8
+CSV_FILE = os.sys.argv[4] if len(os.sys.argv) > 4 else None
+
+import numpy as np
+import serial
+
+# Wire format, see src/io/protocol.h
+OP_PREDICT = 1
+FLAG_TIMESTAMPS = 0x01
+RESPONSE_POSITION = 0
+RESPONSE_ERROR = 4
+RESPONSE_TIMESTAMPED = 0x80
+RESPONSE_UNSOLICITED = 0x40
+TIMESTAMPS = struct.Struct("<4Q")  # arrival, inference start, inference end, enqueue
+
+if CSV_FILE:
+    # Same layout as the model's calibration data: x, y, then 36 RSS values
+    frames = np.loadtxt(CSV_FILE, delimiter=",", skiprows=1, dtype=np.float32)[:, 2:]
+else:
+    frames = np.random.rand(64, 36).astype(np.float32)
+
+def encode_request(seq, leds):
+    payload = leds.astype("<f4").tobytes()
+    return struct.pack("<BBBH", OP_PREDICT, FLAG_TIMESTAMPS, seq, len(payload)) + payload
+
+def read_exact(port, n):
+    data = b""
+    while len(data) < n:
+        chunk = port.read(n - len(data))
+        if not chunk:
+            raise TimeoutError("Device stopped answering")
+        data += chunk
+    return data
+
+def read_response(port):
+    kind, seq, credits, length = struct.unpack("<BBBH", read_exact(port, 5))
+    return kind, seq, read_exact(port, length)
+
+port = serial.Serial(PORT, timeout=2)
+
+sent_at = {}
+stages = {"queue": [], "inference": [], "reply": [], "device": [], "link": [], "total": []}
+
+next_seq = 0
+received = 0
+failures = {}  # VlpError -> count, e.g. DROPPED under an overload policy
+while received < COUNT:
+    # Keep DEPTH requests outstanding
+    while len(sent_at) < DEPTH and next_seq < COUNT:
+        seq = next_seq % 256
+        sent_at[seq] = time.perf_counter_ns()
+        port.write(encode_request(seq, frames[next_seq % len(frames)]))
+        next_seq += 1
+
+    kind, seq, payload = read_response(port)
+    host_receive = time.perf_counter_ns()
+    if kind & RESPONSE_UNSOLICITED:
+        continue  # Telemetry or scalar notifications, their seq may match a request
+    if kind & ~RESPONSE_TIMESTAMPED == RESPONSE_ERROR and seq in sent_at:
+        # Still answers the request, free its place in the window
+        sent_at.pop(seq)
+        failures[payload[0]] = failures.get(payload[0], 0) + 1
+        received += 1
+        continue
+    if kind != (RESPONSE_POSITION | RESPONSE_TIMESTAMPED) or seq not in sent_at:
+        continue
+
+    host_send = sent_at.pop(seq)
+    arrival, start, end, enqueue = TIMESTAMPS.unpack(payload[-TIMESTAMPS.size:])
+
+    # Device stages are in device time, the link is whatever the host saw on
+    # top of the time the request spent on the device
+    total_us = (host_receive - host_send) / 1000
+    stages["queue"].append(start - arrival)
+    stages["inference"].append(end - start)
+    stages["reply"].append(enqueue - end)
+    stages["device"].append(enqueue - arrival)
+    stages["link"].append(total_us - (enqueue - arrival))
+    stages["total"].append(total_us)
+    received += 1
+
+if failures:
+    print("errors: " + ", ".join(f"{count} x code {code}" for code, count in sorted(failures.items())))
+if len(stages["total"]) == 0:
+    exit(1)
+
+print(f"{COUNT} requests, depth {DEPTH}, latency in us")
+print(f"{'stage':<10}{'p50':>10}{'p90':>10}{'p99':>10}{'max':>10}")
+for name, values in stages.items():
+    p50, p90, p99 = np.percentile(values, [50, 90, 99])
+    print(f"{name:<10}{p50:>10.1f}{p90:>10.1f}{p99:>10.1f}{max(values):>10.1f}")
@@ -0,0 +1,88 @@
+import os
+import struct
+
+if len(os.sys.argv) < 3:
+    print("Usage: python replay_eval.py <serial_port> <frames.csv>")
+    exit(1)
+
+PORT = os.sys.argv[1]
+CSV_FILE = os.sys.argv[2]
+
+import numpy as np
+import serial
+
+# Wire format, see src/io/protocol.h
+OP_REPLAY_LOAD = 9
+OP_REPLAY_RUN = 10
+OP_REPLAY_READ = 11
+RESPONSE_ACK = 3
+RESPONSE_ERROR = 4
+RESPONSE_POSITIONS = 5
+RESPONSE_REPLAY_STATS = 7
+RESPONSE_UNSOLICITED = 0x40
+REPLAY_FRAMES = 256
+MAX_PAYLOAD = 8 * 36 * 4
+FRAME = struct.Struct("<38f")  # 36 RSS values, then ground truth x, y
+LOAD_CHUNK = (MAX_PAYLOAD - 2) // FRAME.size
+READ_CHUNK = MAX_PAYLOAD // 8
+STATS = struct.Struct("<3I5f")
+
+# Same layout as the model's calibration data: x, y, then 36 RSS values
+data = np.loadtxt(CSV_FILE, delimiter=",", skiprows=1, dtype=np.float32)
+positions, frames = data[:, :2], data[:, 2:]
+
+def read_exact(port, n):
+    data = b""
+    while len(data) < n:
+        chunk = port.read(n - len(data))
+        if not chunk:
+            raise TimeoutError("Device stopped answering")
+        data += chunk
+    return data
+
+seq = 0
+def request(port, opcode, payload, expected):
+    # One request at a time, so any frame with another seq is a notification,
+    # unsolicited frames can carry the same seq and are told apart by their type
+    global seq
+    seq = (seq + 1) % 256
+    port.write(struct.pack("<BBBH", opcode, 0, seq, len(payload)) + payload)
+    while True:
+        kind, reply_seq, credits, length = struct.unpack("<BBBH", read_exact(port, 5))
+        body = read_exact(port, length)
+        if kind & RESPONSE_UNSOLICITED or reply_seq != seq:
+            continue
+        if kind != expected:
+            raise RuntimeError(f"Opcode {opcode} failed with reply {kind} {body.hex()}")
+        return body
+
+port = serial.Serial(PORT, timeout=5)
+
+predictions = []
+elapsed_us = 0
+failures = 0
+for start in range(0, len(frames), REPLAY_FRAMES):
+    count = min(REPLAY_FRAMES, len(frames) - start)
+
+    for first in range(0, count, LOAD_CHUNK):
+        n = min(LOAD_CHUNK, count - first)
+        payload = struct.pack("<H", first) + b"".join(
+            FRAME.pack(*frames[start + i], *positions[start + i]) for i in range(first, first + n))
+        request(port, OP_REPLAY_LOAD, payload, RESPONSE_ACK)
+
+    stats = STATS.unpack(request(port, OP_REPLAY_RUN, struct.pack("<H", count), RESPONSE_REPLAY_STATS))
+    elapsed_us += stats[2]
+    failures += stats[1]
+    print(f"frames {start}..{start + count - 1}: {stats[2] / count:.1f} us/frame, "
+          f"mean {stats[3]:.2f} rms {stats[4]:.2f} p50 {stats[5]:.2f} p95 {stats[6]:.2f} max {stats[7]:.2f}")
+
+    for first in range(0, count, READ_CHUNK):
+        n = min(READ_CHUNK, count - first)
+        body = request(port, OP_REPLAY_READ, struct.pack("<HH", first, n), RESPONSE_POSITIONS)
+        predictions.append(np.frombuffer(body, dtype="<f4").reshape(-1, 2))
+
+errors = np.linalg.norm(np.concatenate(predictions) - positions, axis=1)
+errors = errors[~np.isnan(errors)]
+print(f"{len(frames)} frames, {failures} failed, {elapsed_us / len(frames):.1f} us/frame on device")
+print(f"error mean {errors.mean():.2f} rms {np.sqrt((errors ** 2).mean()):.2f} "
+      f"p50 {np.percentile(errors, 50):.2f} p95 {np.percentile(errors, 95):.2f} max {errors.max():.2f}")
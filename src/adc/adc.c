@@ -0,0 +1,55 @@
+#include "adc.h"
+
+#include <math.h>
+#include <string.h>
+
+// Only ratios between channels matter, the model input is normalized, so the
+// default table passes counts through unchanged
+static VlpAdcCalibration calibration[VLP_LED_COUNT] = {
+    [0 ... VLP_LED_COUNT - 1] = {0.0f, 1.0f},
+};
+
+static inline float to_rss(int channel, uint16_t count)
+{
+    return ((float)count - calibration[channel].offset) * calibration[channel].gain;
+}
+
+void adc12_to_rss(const uint8_t *packed, float rss[VLP_LED_COUNT])
+{
+    for (int i = 0; i < VLP_LED_COUNT; i += 2)
+    {
+        const uint8_t *p = &packed[i / 2 * 3];
+        rss[i] = to_rss(i, (uint16_t)(p[0] | (p[1] & 0x0F) << 8));
+        rss[i + 1] = to_rss(i + 1, (uint16_t)(p[1] >> 4 | p[2] << 4));
+    }
+}
+
+void adc16_to_rss(const uint8_t *counts, float rss[VLP_LED_COUNT])
+{
+    for (int i = 0; i < VLP_LED_COUNT; i++)
+    {
+        rss[i] = to_rss(i, (uint16_t)(counts[2 * i] | counts[2 * i + 1] << 8));
+    }
+}
+
+const VlpAdcCalibration *get_adc_calibration(void)
+{
+    return calibration;
+}
+
+bool set_adc_calibration(const uint8_t *table)
+{
+    // A bad entry would silently turn every later prediction into NaN
+    for (int i = 0; i < VLP_LED_COUNT; i++)
+    {
+        VlpAdcCalibration entry;
+        memcpy(&entry, &table[i * sizeof(entry)], sizeof(entry));
+        if (!isfinite(entry.offset) || !isfinite(entry.gain) || entry.gain <= 0.0f)
+        {
+            return false;
+        }
+    }
+
+    memcpy(calibration, table, sizeof(calibration));
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef ADC_H
+#define ADC_H
+
+#include "../io/protocol.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Converts 12-bit packed ADC counts to RSS values.
+ *
+ * @param packed VLP_ADC12_BYTES bytes, packed as described in protocol.h.
+ * @param rss Receives VLP_LED_COUNT RSS values.
+ */
+void adc12_to_rss(const uint8_t *packed, float rss[VLP_LED_COUNT]);
+
+/**
+ * @brief Converts little-endian 16-bit ADC counts to RSS values.
+ *
+ * @param counts VLP_ADC16_BYTES bytes, need not be aligned.
+ * @param rss Receives VLP_LED_COUNT RSS values.
+ */
+void adc16_to_rss(const uint8_t *counts, float rss[VLP_LED_COUNT]);
+
+/**
+ * @brief Returns the per-channel calibration table, offset 0 and gain 1 by default.
+ */
+const VlpAdcCalibration *get_adc_calibration(void);
+
+/**
+ * @brief Replaces the per-channel calibration table.
+ *
+ * @param table VLP_LED_COUNT packed VlpAdcCalibration entries, need not be aligned.
+ * @return false, keeping the old table, if an offset or gain is not finite
+ *         or a gain is not positive.
+ */
+bool set_adc_calibration(const uint8_t *table);
+
+#endif // ADC_H
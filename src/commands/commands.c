@@ -0,0 +1,480 @@
+#include "commands.h"
+
+#include "../adc/adc.h"
+#include "../debug.h"
+#include "../degradation_model/degradation_model.h"
+#include "../io/io.h"
+#include "../model/model.h"
+#include "../replay/replay.h"
+#include "../telemetry/telemetry.h"
+
+#include "pico/stdlib.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef void (*CommandHandler)(IncomingPacket *packet);
+
+// Link benchmarking, every request is echoed through the regular IO path
+static bool loopback = false;
+
+// The CALIBRATE_SAMPLE that started the running recalibration
+static uint8_t recalibration_seq = 0;
+
+#define DEFAULT_SCALAR_EPSILON 0.001f
+
+// Scalars the host of the current session was last sent, see VlpScalarDelta
+static float host_scalars[VLP_LED_COUNT];
+static bool host_synced = false;
+static bool scalar_deltas = false;
+static uint32_t session = 0; // io_session() the state above belongs to
+static float scalar_epsilon = DEFAULT_SCALAR_EPSILON;
+
+typedef struct Command
+{
+    CommandHandler handler;
+    uint16_t min_len; // Fixed part of the payload
+    uint16_t stride;  // Size of each repeated element after it, 0 if there are none
+    uint16_t max_len;
+} Command;
+
+// Runs inference on a payload frame and records its time
+static TfLiteStatus timed_predict(IncomingPacket *packet, const uint8_t *frame, float *x, float *y)
+{
+    uint64_t start_us = time_us_64();
+    TfLiteStatus status = predict_frame(frame, x, y);
+    uint64_t end_us = time_us_64();
+    telemetry_record(VLP_HISTOGRAM_INFERENCE, (uint32_t)(end_us - start_us));
+
+    if (packet->inference_start_us == 0)
+    {
+        packet->inference_start_us = start_us;
+    }
+    packet->inference_end_us = end_us;
+    return status;
+}
+
+// Predicts from one float frame and answers with the position, shared by
+// PREDICT and the raw ADC frames once they are converted
+static void predict_rss(IncomingPacket *packet, const float rss[VLP_LED_COUNT])
+{
+    float x, y;
+    if (timed_predict(packet, (const uint8_t *)rss, &x, &y) != kTfLiteOk)
+    {
+        write_position(packet, NAN, NAN);
+        return;
+    }
+
+    DEBUG_LED_BLINK(5, 100);
+    write_position(packet, x, y);
+}
+
+static void handle_predict(IncomingPacket *packet)
+{
+    predict_rss(packet, io_payload_floats(packet));
+}
+
+static void handle_predict_adc12(IncomingPacket *packet)
+{
+    float rss[VLP_LED_COUNT];
+    adc12_to_rss(packet->payload, rss);
+    predict_rss(packet, rss);
+}
+
+static void handle_predict_adc16(IncomingPacket *packet)
+{
+    float rss[VLP_LED_COUNT];
+    adc16_to_rss(packet->payload, rss);
+    predict_rss(packet, rss);
+}
+
+static void handle_set_adc_calibration(IncomingPacket *packet)
+{
+    if (!set_adc_calibration(packet->payload))
+    {
+        write_error(packet, VLP_ERROR_BAD_PARAM);
+        return;
+    }
+    write_ack(packet);
+}
+
+static void handle_get_adc_calibration(IncomingPacket *packet)
+{
+    write_reply(packet, VLP_RESPONSE_ADC_CALIBRATION, get_adc_calibration(),
+                VLP_LED_COUNT * sizeof(VlpAdcCalibration));
+}
+
+static void handle_calibrate_sample(IncomingPacket *packet)
+{
+    float x, y;
+    if (timed_predict(packet, packet->payload, &x, &y) != kTfLiteOk)
+    {
+        write_position(packet, NAN, NAN);
+        return;
+    }
+
+    DEBUG_LED_BLINK(5, 100);
+
+    // The window keeps the measured values, they are scaled when fitted
+    if (add_sample(io_payload_floats(packet), x, y))
+    {
+        recalibration_seq = packet->seq;
+    }
+    write_position(packet, x, y);
+}
+
+static void reset_session(void)
+{
+    session = io_session();
+    host_synced = false;
+    scalar_deltas = false;
+}
+
+// A different host may be on the other end once the link reconnected
+static void check_session(void)
+{
+    if (session != io_session())
+    {
+        reset_session();
+    }
+}
+
+static void sync_host_scalars(const float scalars[VLP_LED_COUNT])
+{
+    memcpy(host_scalars, scalars, sizeof(host_scalars));
+    host_synced = true;
+}
+
+// Reports the scalars that moved by more than the epsilon since the host last
+// saw them, a full SCALARS frame when it has no baseline
+static void notify_scalars(uint8_t seq)
+{
+    check_session();
+    const float *scalars = get_scalars();
+    if (!scalar_deltas || !host_synced)
+    {
+        if (write_packet(VLP_RESPONSE_SCALARS, seq, scalars, VLP_LED_COUNT * sizeof(float)))
+        {
+            sync_host_scalars(scalars);
+        }
+        return;
+    }
+
+    uint8_t payload[1 + VLP_LED_COUNT * sizeof(VlpScalarDelta)];
+    VlpScalarDelta deltas[VLP_LED_COUNT];
+    uint8_t count = 0;
+    for (int i = 0; i < VLP_LED_COUNT; i++)
+    {
+        if (fabsf(scalars[i] - host_scalars[i]) > scalar_epsilon)
+        {
+            deltas[count++] = (VlpScalarDelta){(uint8_t)i, scalars[i]};
+        }
+    }
+    payload[0] = count;
+    memcpy(&payload[1], deltas, count * sizeof(VlpScalarDelta));
+
+    // Sent even when empty, it still tells the host the recalibration finished
+    if (!write_packet(VLP_RESPONSE_SCALAR_DELTA, seq, payload, 1 + count * sizeof(VlpScalarDelta)))
+    {
+        return; // Dropped, the next delta covers these as well
+    }
+    for (int j = 0; j < count; j++)
+    {
+        host_scalars[deltas[j].index] = deltas[j].value;
+    }
+}
+
+static void handle_get_scalars(IncomingPacket *packet)
+{
+    const float *scalars = get_scalars();
+    if (write_scalars(packet, scalars))
+    {
+        sync_host_scalars(scalars);
+    }
+}
+
+static void handle_set_scalars(IncomingPacket *packet)
+{
+    // Scalars are checkpointed to flash, a bad set would survive reboots
+    const float *scalars = io_payload_floats(packet);
+    for (int i = 0; i < VLP_LED_COUNT; i++)
+    {
+        if (!isfinite(scalars[i]) || scalars[i] <= 0.0f)
+        {
+            write_error(packet, VLP_ERROR_BAD_PARAM);
+            return;
+        }
+    }
+
+    set_scalars(scalars);
+    sync_host_scalars(scalars);
+    write_ack(packet);
+}
+
+// Converts a parameter value to an int, false if it does not fit one. The
+// bounds are the nearest floats, INT_MAX itself is not representable.
+static bool int_param(float value, int *out)
+{
+    if (!(value >= -2147483648.0f && value < 2147483648.0f))
+    {
+        return false;
+    }
+    *out = (int)value;
+    return true;
+}
+
+static void handle_set_param(IncomingPacket *packet)
+{
+    uint8_t param = packet->payload[0];
+    float value;
+    memcpy(&value, &packet->payload[1], sizeof(value)); // Unaligned after the id byte
+    if (!isfinite(value))
+    {
+        write_error(packet, VLP_ERROR_BAD_PARAM);
+        return;
+    }
+
+    DegradationParams params = get_degradation_params();
+    bool ok = true;
+    bool model_param = true; // Belongs to the degradation model
+    switch (param)
+    {
+    case VLP_PARAM_RANSAC_THRESHOLD:
+        params.ransac_threshold = value;
+        break;
+    case VLP_PARAM_RANSAC_ITERATIONS:
+        ok = int_param(value, &params.ransac_iterations);
+        break;
+    case VLP_PARAM_RANSAC_SEED:
+        ok = int_param(value, &params.ransac_seed);
+        break;
+    case VLP_PARAM_SAMPLES_PER_UPDATE:
+        ok = int_param(value, &params.samples_per_update);
+        break;
+    case VLP_PARAM_REFRESH_INTERVAL:
+        ok = int_param(value, &params.refresh_interval);
+        break;
+    case VLP_PARAM_FORGETTING_FACTOR:
+        params.forgetting_factor = value;
+        break;
+    case VLP_PARAM_RANSAC_CONFIDENCE:
+        params.ransac_confidence = value;
+        break;
+    case VLP_PARAM_MIN_LED_SAMPLES:
+        ok = int_param(value, &params.min_led_samples);
+        break;
+    case VLP_PARAM_TELEMETRY_PERIOD_MS:
+        model_param = false;
+        ok = value >= 0.0f && value < 4294967296.0f;
+        if (ok)
+        {
+            telemetry_set_period_ms((uint32_t)value);
+        }
+        break;
+    case VLP_PARAM_LOOPBACK:
+        model_param = false;
+        loopback = value != 0.0f;
+        break;
+    case VLP_PARAM_SCALAR_DELTAS:
+        model_param = false;
+        scalar_deltas = value != 0.0f;
+        break;
+    case VLP_PARAM_SCALAR_EPSILON:
+        model_param = false;
+        ok = value >= 0.0f;
+        if (ok)
+        {
+            scalar_epsilon = value;
+        }
+        break;
+    case VLP_PARAM_OVERLOAD_POLICY:
+        model_param = false;
+        ok = value >= 0.0f && value < VLP_OVERLOAD_POLICY_COUNT;
+        if (ok)
+        {
+            io_set_overload_policy((VlpOverloadPolicy)value);
+        }
+        break;
+    default:
+        ok = false;
+        break;
+    }
+
+    if (ok && model_param)
+    {
+        ok = set_degradation_params(&params);
+    }
+
+    if (!ok)
+    {
+        write_error(packet, VLP_ERROR_BAD_PARAM);
+        return;
+    }
+    write_ack(packet);
+}
+
+static void handle_get_stats(IncomingPacket *packet)
+{
+    telemetry_send(packet);
+}
+
+static void handle_reset_buffer(IncomingPacket *packet)
+{
+    reset_samples();
+    write_ack(packet);
+}
+
+static void handle_batch_predict(IncomingPacket *packet)
+{
+    int frames = packet->len / VLP_LED_BYTES;
+    float positions[2 * VLP_MAX_BATCH];
+
+    for (int i = 0; i < frames; i++)
+    {
+        float *x = &positions[2 * i];
+        float *y = &positions[2 * i + 1];
+        if (timed_predict(packet, &packet->payload[i * VLP_LED_BYTES], x, y) != kTfLiteOk)
+        {
+            *x = NAN;
+            *y = NAN;
+        }
+    }
+
+    DEBUG_LED_BLINK(5, 100);
+    write_reply(packet, VLP_RESPONSE_POSITIONS, positions, (uint16_t)(frames * 2 * sizeof(float)));
+}
+
+static void handle_echo(IncomingPacket *packet)
+{
+    write_reply(packet, VLP_RESPONSE_ECHO, packet->payload, packet->len);
+}
+
+static uint16_t payload_u16(const IncomingPacket *packet, int offset)
+{
+    uint16_t value;
+    memcpy(&value, &packet->payload[offset], sizeof(value));
+    return value;
+}
+
+static void handle_replay_load(IncomingPacket *packet)
+{
+    int count = (packet->len - sizeof(uint16_t)) / sizeof(VlpReplayFrame);
+    if (!replay_store(payload_u16(packet, 0), &packet->payload[sizeof(uint16_t)], count))
+    {
+        write_error(packet, VLP_ERROR_BAD_PARAM);
+        return;
+    }
+    write_ack(packet);
+}
+
+static void handle_replay_run(IncomingPacket *packet)
+{
+    VlpReplayStats stats;
+    packet->inference_start_us = time_us_64();
+    bool ok = replay_run(payload_u16(packet, 0), &stats);
+    packet->inference_end_us = time_us_64();
+
+    if (!ok)
+    {
+        write_error(packet, VLP_ERROR_BAD_PARAM);
+        return;
+    }
+    DEBUG_LED_BLINK(5, 100);
+    write_reply(packet, VLP_RESPONSE_REPLAY_STATS, &stats, sizeof(stats));
+}
+
+static void handle_replay_read(IncomingPacket *packet)
+{
+    uint16_t count = payload_u16(packet, sizeof(uint16_t));
+    const float *positions = replay_positions(payload_u16(packet, 0), count);
+    if (!positions || count > VLP_REPLAY_READ_CHUNK)
+    {
+        write_error(packet, VLP_ERROR_BAD_PARAM);
+        return;
+    }
+    write_reply(packet, VLP_RESPONSE_POSITIONS, positions, (uint16_t)(count * 2 * sizeof(float)));
+}
+
+static const Command commands[VLP_OPCODE_COUNT] = {
+    [VLP_OP_CALIBRATE_SAMPLE] = {handle_calibrate_sample, VLP_LED_BYTES, 0, VLP_LED_BYTES},
+    [VLP_OP_PREDICT] = {handle_predict, VLP_LED_BYTES, 0, VLP_LED_BYTES},
+    [VLP_OP_GET_SCALARS] = {handle_get_scalars, 0, 0, 0},
+    [VLP_OP_SET_SCALARS] = {handle_set_scalars, VLP_LED_BYTES, 0, VLP_LED_BYTES},
+    [VLP_OP_SET_PARAM] = {handle_set_param, 1 + sizeof(float), 0, 1 + sizeof(float)},
+    [VLP_OP_GET_STATS] = {handle_get_stats, 0, 0, 0},
+    [VLP_OP_RESET_BUFFER] = {handle_reset_buffer, 0, 0, 0},
+    [VLP_OP_BATCH_PREDICT] = {handle_batch_predict, VLP_LED_BYTES, VLP_LED_BYTES, VLP_MAX_PAYLOAD},
+    [VLP_OP_ECHO] = {handle_echo, 0, 1, VLP_MAX_PAYLOAD},
+    [VLP_OP_REPLAY_LOAD] = {handle_replay_load, sizeof(uint16_t), sizeof(VlpReplayFrame),
+                            sizeof(uint16_t) + VLP_REPLAY_CHUNK * sizeof(VlpReplayFrame)},
+    [VLP_OP_REPLAY_RUN] = {handle_replay_run, sizeof(uint16_t), 0, sizeof(uint16_t)},
+    [VLP_OP_REPLAY_READ] = {handle_replay_read, 2 * sizeof(uint16_t), 0, 2 * sizeof(uint16_t)},
+    [VLP_OP_PREDICT_ADC12] = {handle_predict_adc12, VLP_ADC12_BYTES, 0, VLP_ADC12_BYTES},
+    [VLP_OP_PREDICT_ADC16] = {handle_predict_adc16, VLP_ADC16_BYTES, 0, VLP_ADC16_BYTES},
+    [VLP_OP_SET_ADC_CALIBRATION] = {handle_set_adc_calibration, VLP_LED_COUNT * sizeof(VlpAdcCalibration), 0,
+                                    VLP_LED_COUNT * sizeof(VlpAdcCalibration)},
+    [VLP_OP_GET_ADC_CALIBRATION] = {handle_get_adc_calibration, 0, 0, 0},
+};
+
+static bool valid_length(const Command *command, uint16_t len)
+{
+    if (len < command->min_len || len > command->max_len)
+    {
+        return false;
+    }
+    if (command->stride == 0)
+    {
+        return len == command->min_len;
+    }
+    return (len - command->min_len) % command->stride == 0;
+}
+
+void commands_handle_next(void)
+{
+    IncomingPacket *packet = io_peek_request();
+
+    // Free the slot before answering so the reply advertises it, the packet
+    // stays valid until the next poll
+    io_pop_request();
+    telemetry_count(TELEMETRY_PACKETS_ANSWERED);
+
+    check_session();
+    if (packet->flags & VLP_FLAG_NEW_SESSION)
+    {
+        reset_session();
+    }
+
+    if (loopback && packet->opcode != VLP_OP_SET_PARAM)
+    {
+        handle_echo(packet);
+        return;
+    }
+
+    if (packet->opcode >= VLP_OPCODE_COUNT || !commands[packet->opcode].handler)
+    {
+        telemetry_count(TELEMETRY_PARSE_ERRORS);
+        write_error(packet, VLP_ERROR_UNKNOWN_OPCODE);
+        return;
+    }
+
+    const Command *command = &commands[packet->opcode];
+    if (!valid_length(command, packet->len))
+    {
+        telemetry_count(TELEMETRY_PARSE_ERRORS);
+        write_error(packet, VLP_ERROR_BAD_LENGTH);
+        return;
+    }
+
+    command->handler(packet);
+}
+
+bool commands_recalibration_task(uint32_t budget_us)
+{
+    uint32_t elapsed_us;
+    if (recalibration_finished(&elapsed_us))
+    {
+        telemetry_record(VLP_HISTOGRAM_RECALIBRATION, elapsed_us);
+        notify_scalars(recalibration_seq);
+    }
+    return false; // Only polls, the fitting happens on core1
+}
@@ -0,0 +1,24 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Answers the oldest queued request.
+ *
+ * Looks the opcode up in the dispatch table, validates the payload length and
+ * runs the handler. Every request, including invalid ones, gets exactly one
+ * reply so the host always gets its credit back. Handlers never allocate.
+ */
+void commands_handle_next(void);
+
+/**
+ * @brief Background task that picks up recalibrations finished by core1.
+ *
+ * Once the new scalars are published they are sent unsolicited as SCALARS,
+ * tagged with the seq of the CALIBRATE_SAMPLE that started the recalibration.
+ */
+bool commands_recalibration_task(uint32_t budget_us);
+
+#endif // COMMANDS_H
@@ -5,7 +5,7 @@
 
 #ifdef DEBUG_LED
 #define DEBUG_LED_INIT() led_init()
-#define DEBUG_LED_BLINK(times, interval_ms) led_blink(times, interval_ms)
+#define DEBUG_LED_BLINK(times, interval_ms) led_blink_async(times, interval_ms)
 #define DEBUG_LED_SET(value) led_set(value)
 #else
 #define DEBUG_LED_INIT() ((void)0)
@@ -3,81 +3,681 @@
 #include "../data/data.h"
 #include "../data/lambertian.h"
 
+#include "hardware/sync.h"
+#include "pico/util/queue.h"
+#include "pico/time.h"
 #include "ransac_line.h"
+#include <math.h>
 #include <string.h>
 #include <stdbool.h>
 
-float sample_buffer_leds[BUFFER_SIZE_LEDS] = {0.0f};
-int sample_buffer_positions[BUFFER_SIZE_POSITIONS] = {0};
-int sample_amount = 0;
+// Readers use whichever bank active_scalars points at, writers fill the other
+// one and swap the pointer under scalars_lock. A reader that fetched the
+// pointer just before a swap keeps a consistent, if old, set.
+static float scalar_banks[2][TX_POSITIONS_COUNT] = {
+    [0 ... 1] = {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
+};
+static float *volatile active_scalars = scalar_banks[0];
+static spin_lock_t *scalars_lock = NULL;
 
-float scalars[TX_POSITIONS_COUNT] = {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
+// Bumped by set_scalars() and reset_samples(), a fit that started under an
+// older generation is thrown away instead of published
+static volatile uint32_t scalars_generation = 0;
+
+static LedFitStats fit_stats; // Of the last recalibration collected on core0
+
+static DegradationParams params = {
+    .ransac_threshold = 0.1f,
+    .ransac_iterations = 25,
+    .ransac_seed = 42,
+    .samples_per_update = MAX_SAMPLES,
+    .refresh_interval = DEFAULT_REFRESH_INTERVAL,
+    .forgetting_factor = DEFAULT_FORGETTING_FACTOR,
+    .ransac_confidence = DEFAULT_RANSAC_CONFIDENCE,
+    .min_led_samples = DEFAULT_MIN_LED_SAMPLES,
+};
 
 static inline int div_round_nearest(int a, int b)
 {
     return (a + (b >> 1)) / b;
 }
 
-static void update_scalars()
+// Copies new values into the inactive bank and makes it the active one
+static void publish_scalars(const float new_scalars[TX_POSITIONS_COUNT])
+{
+    float *inactive = active_scalars == scalar_banks[0] ? scalar_banks[1] : scalar_banks[0];
+    memcpy(inactive, new_scalars, sizeof(scalar_banks[0]));
+    __dmb(); // Values before the pointer
+    active_scalars = inactive;
+}
+
+#ifdef DEGRADATION_ESTIMATOR_RLS
+
+// Recursive least squares on reference = scalar * measured, one independent
+// estimate per LED. No samples are kept, every add_sample() folds its sample
+// into the estimates and publishes them.
+#define RLS_INITIAL_COVARIANCE 1000.0f // Little confidence in the starting scalars
+
+static float rls_scalars[TX_POSITIONS_COUNT];
+static float rls_covariance[TX_POSITIONS_COUNT];
+static int samples_since_refresh = 0;
+static bool report_due = false;
+static uint32_t update_us = 0; // Spent on updates since the last report
+
+static void rls_restart(const float start_scalars[TX_POSITIONS_COUNT])
+{
+    memcpy(rls_scalars, start_scalars, sizeof(rls_scalars));
+    for (int i = 0; i < TX_POSITIONS_COUNT; i++)
+    {
+        rls_covariance[i] = RLS_INITIAL_COVARIANCE;
+    }
+    samples_since_refresh = 0;
+}
+
+// Huber-weighted RLS step, samples with residuals beyond the threshold count
+// less the further out they are
+static void rls_update(int i, float measured, float reference)
+{
+    float error = reference - rls_scalars[i] * measured;
+    float abs_error = fabsf(error);
+    float weight = abs_error <= params.ransac_threshold ? 1.0f : params.ransac_threshold / abs_error;
+
+    float lambda = params.forgetting_factor;
+    float p = rls_covariance[i];
+    float gain = p * measured * weight / (lambda + weight * measured * measured * p);
+    rls_scalars[i] += gain * error;
+
+    // Forgetting inflates the covariance while an LED sees no signal, keep it bounded
+    p = (p - gain * measured * p) / lambda;
+    rls_covariance[i] = p < RLS_INITIAL_COVARIANCE ? p : RLS_INITIAL_COVARIANCE;
+}
+
+bool add_sample(const float sample[TX_POSITIONS_COUNT], float x, float y)
+{
+    uint64_t start_us = time_us_64();
+
+    float references[TX_POSITIONS_COUNT];
+    if (get_augmented_data(div_round_nearest(x, 10), div_round_nearest(y, 10), references) == 0)
+    {
+        for (int i = 0; i < TX_POSITIONS_COUNT; i++)
+        {
+            if (references[i] >= 0.0f)
+            {
+                rls_update(i, sample[i], references[i]);
+            }
+        }
+
+        uint32_t save = spin_lock_blocking(scalars_lock);
+        publish_scalars(rls_scalars);
+        spin_unlock(scalars_lock, save);
+    }
+    update_us += (uint32_t)(time_us_64() - start_us);
+
+    // Report the scalars at the cadence the windowed fit would refresh them
+    if (++samples_since_refresh < params.refresh_interval)
+    {
+        return false;
+    }
+    samples_since_refresh = 0;
+    report_due = true;
+    return true;
+}
+
+bool recalibration_finished(uint32_t *elapsed_us)
+{
+    if (!report_due)
+    {
+        return false;
+    }
+
+    report_due = false;
+    *elapsed_us = update_us;
+    update_us = 0;
+    return true;
+}
+
+bool recalibrate_step()
+{
+    return false; // Nothing runs on core1
+}
+
+static void estimator_init()
+{
+    rls_restart(active_scalars);
+}
+
+static void estimator_scalars_replaced(const float new_scalars[TX_POSITIONS_COUNT])
+{
+    rls_restart(new_scalars);
+}
+
+static void estimator_samples_reset()
+{
+    rls_restart(active_scalars);
+}
+
+#else // Windowed fit on core1
+
+#define RANSAC_MIN_INLIER_FRACTION 0.01f // Keeps the adaptive iteration count finite
+#define CELL_WEIGHT_CAP 8 // Samples a cell's running mean averages over, so it still follows drift
+
+typedef struct SampleBuffer
 {
-    sample_amount = 0; // Reset to zero
+    float leds[BUFFER_SIZE_LEDS];
+    int positions[BUFFER_SIZE_POSITIONS];
+    int slots[MAX_SAMPLES]; // Window slot of each sample
+    int amount;
 
-    float samples[MAX_SAMPLES] = {0};
-    float reference_samples[MAX_SAMPLES] = {0};
+    // Filled in by core0 when handing the buffer to core1
+    DegradationParams params;
+    uint32_t generation;
 
+    // Filled in by core1 when handing it back
+    bool published;
+    uint32_t elapsed_us;
+    LedFitStats fit_stats;
+} SampleBuffer;
+
+// Sliding window of the latest unscaled samples, owned by core0, one slot
+// per (x / 10, y / 10) grid cell. A sample in a cell the window already
+// holds is merged into that cell's running mean, a sample in a new cell
+// evicts the oldest cell.
+static float window_leds[BUFFER_SIZE_LEDS];
+static int window_positions[BUFFER_SIZE_POSITIONS];
+static int window_weights[MAX_SAMPLES]; // Samples merged into each slot, at most CELL_WEIGHT_CAP
+static int window_head = 0;  // Slot the next cell goes into
+static int window_count = 0; // Valid cells, at most MAX_SAMPLES
+static int cells_since_refresh = 0;
+
+// Reference RSS of the cell in each window slot, owned by core1. A slot only
+// changes cell when a new cell evicts the old one, so the references are
+// resolved once per inserted cell and reused by every later fit. The cell
+// they were resolved for tells whether they are still current. LEDs without
+// reference data are negative.
+static float slot_references[MAX_SAMPLES][TX_POSITIONS_COUNT];
+static int slot_reference_cells[BUFFER_SIZE_POSITIONS];
+static bool slot_resolved[MAX_SAMPLES];
+
+// Snapshot of the window handed to core1 through to_core1, it comes back
+// through to_core0 once fitted, so it has a single owner at any time. Not
+// the SIO FIFO, that belongs to the multicore lockout of flash writes.
+static SampleBuffer fit_buffer;
+static bool fitting = false;
+static queue_t to_core1;
+static queue_t to_core0;
+
+// Core1 state of the running fit. The first pass looks up each sample's
+// reference RSS and sorts the valid pairs per LED, so every fit reads two
+// contiguous arrays.
+static SampleBuffer *core1_buffer = NULL;
+static int next_sample = 0;
+static int next_led = 0;
+static float led_samples[TX_POSITIONS_COUNT][MAX_SAMPLES];
+static float led_references[TX_POSITIONS_COUNT][MAX_SAMPLES];
+static int led_sample_counts[TX_POSITIONS_COUNT];
+static float next_scalars[TX_POSITIONS_COUNT];
+static uint64_t fit_start_us = 0;
+
+// Returns the reference RSS of all LEDs for one sample, reconstructing them
+// only if its slot holds a cell they were not resolved for yet
+static const float *slot_reference(const SampleBuffer *buffer, int j)
+{
+    int slot = buffer->slots[j];
+    int cell_x = buffer->positions[j * 2];
+    int cell_y = buffer->positions[j * 2 + 1];
+    float *references = slot_references[slot];
+    if (slot_resolved[slot] && slot_reference_cells[slot * 2] == cell_x && slot_reference_cells[slot * 2 + 1] == cell_y)
+    {
+        return references;
+    }
+
+    if (get_augmented_data(cell_x, cell_y, references) != 0)
+    {
+        // No reference data at this position
+        for (int i = 0; i < TX_POSITIONS_COUNT; i++)
+        {
+            references[i] = -1.0f;
+        }
+    }
+    slot_reference_cells[slot * 2] = cell_x;
+    slot_reference_cells[slot * 2 + 1] = cell_y;
+    slot_resolved[slot] = true;
+    return references;
+}
+
+// Files the valid (sample, reference) pairs of one sample under their LED
+static void add_references(const SampleBuffer *buffer, int j)
+{
+    const float *references = slot_reference(buffer, j);
+
+    // Samples are stored unscaled, so ones that outlived an earlier update are
+    // fitted relative to the current scalars just like fresh ones
+    const float *sample = &buffer->leds[j * TX_POSITIONS_COUNT];
     for (int i = 0; i < TX_POSITIONS_COUNT; i++)
     {
-        int sample_count = 0; // Valid sample count for this LED
-        for (int j = 0; j < MAX_SAMPLES; j++)
+        if (references[i] < 0.0f)
         {
-            // Get the reference RSS sample for the current LED position
-            float ref = get_augmented_data_for_led(
-                sample_buffer_positions[j*2],   // Use the first sample's x position
-                sample_buffer_positions[j*2+1], // Use the first sample's y position
-                i                               // LED index
-            );
-            float sample = sample_buffer_leds[j * TX_POSITIONS_COUNT + i];
+            continue;
+        }
 
-            if (ref < 0.0f)
+        int n = led_sample_counts[i]++;
+        led_samples[i][n] = sample[i] * next_scalars[i];
+        led_references[i][n] = references[i];
+    }
+}
+
+#ifdef DEGRADATION_ESTIMATOR_MEDIAN
+// Returns the k-th smallest value, partially reordering values in the process
+static float quickselect(float *values, int n, int k)
+{
+    int left = 0;
+    int right = n - 1;
+    while (left < right)
+    {
+        float pivot = values[(left + right) / 2];
+        int i = left;
+        int j = right;
+        while (i <= j)
+        {
+            while (values[i] < pivot)
+            {
+                i++;
+            }
+            while (values[j] > pivot)
             {
-                continue;
+                j--;
             }
+            if (i <= j)
+            {
+                float swap = values[i];
+                values[i++] = values[j];
+                values[j--] = swap;
+            }
+        }
+
+        // values[left..j] <= pivot <= values[i..right], anything in between equals it
+        if (k <= j)
+        {
+            right = j;
+        }
+        else if (k >= i)
+        {
+            left = i;
+        }
+        else
+        {
+            break;
+        }
+    }
+    return values[k];
+}
+
+// Median of reference / sample, the exact robust fit of a single scale
+// factor. Deterministic and O(n) on average, tolerates up to half the
+// samples being outliers. Returns 1, keeping the scalar, without samples.
+static float median_of_ratios(const float *samples, const float *references, int n)
+{
+    float ratios[MAX_SAMPLES];
+    int count = 0;
+    for (int j = 0; j < n; j++)
+    {
+        if (samples[j] > 0.0f)
+        {
+            ratios[count++] = references[j] / samples[j];
+        }
+    }
+
+    if (count == 0)
+    {
+        return 1.0f;
+    }
+
+    int middle = count / 2;
+    float upper = quickselect(ratios, count, middle);
+    if (count % 2 == 1)
+    {
+        return upper;
+    }
+
+    // Everything below the middle is now in ratios[0..middle-1]
+    float lower = ratios[0];
+    for (int j = 1; j < middle; j++)
+    {
+        lower = ratios[j] > lower ? ratios[j] : lower;
+    }
+    return (lower + upper) / 2.0f;
+}
+#else
+// RANSAC on reference = scale * sample, where a single pair determines the
+// scale. Stops once the best inlier fraction w found so far makes another
+// all-outlier run unlikely, i.e. after log(1 - confidence) / log(1 - w)
+// iterations, but never after more than ransac_iterations. The scale is
+// refined by least squares over the inliers of the best hypothesis.
+static float adaptive_fit(const float *samples, const float *references, int n,
+                          const DegradationParams *fit_params, int *iterations)
+{
+    uint32_t state = (uint32_t)fit_params->ransac_seed;
+    float threshold = fit_params->ransac_threshold;
+    float log_outlier_run = logf(1.0f - fit_params->ransac_confidence);
+    int needed = fit_params->ransac_iterations;
+    int best_inliers = 0;
+    float best_scale = 1.0f;
+
+    int k = 0;
+    while (k < needed)
+    {
+        k++;
+        state = state * 1664525u + 1013904223u; // Numerical Recipes LCG
+        int j = (int)((state >> 8) % (uint32_t)n);
+        if (samples[j] <= 0.0f)
+        {
+            continue;
+        }
 
-            samples[sample_count] = sample;
-            reference_samples[sample_count] = ref;
-            sample_count++;
+        float scale = references[j] / samples[j];
+        int inliers = 0;
+        for (int m = 0; m < n; m++)
+        {
+            inliers += fabsf(references[m] - scale * samples[m]) < threshold;
+        }
+        if (inliers <= best_inliers)
+        {
+            continue;
         }
 
+        best_inliers = inliers;
+        best_scale = scale;
+        float fraction = (float)inliers / n;
+        if (fraction >= 1.0f)
+        {
+            break;
+        }
+        fraction = fraction > RANSAC_MIN_INLIER_FRACTION ? fraction : RANSAC_MIN_INLIER_FRACTION;
+        float adaptive = ceilf(log_outlier_run / logf(1.0f - fraction));
+        if (adaptive < needed)
+        {
+            needed = (int)adaptive;
+        }
+    }
+    *iterations = k;
+
+    float sum_xy = 0.0f;
+    float sum_xx = 0.0f;
+    for (int m = 0; m < n; m++)
+    {
+        if (fabsf(references[m] - best_scale * samples[m]) < threshold)
+        {
+            sum_xy += samples[m] * references[m];
+            sum_xx += samples[m] * samples[m];
+        }
+    }
+    return sum_xx > 0.0f ? sum_xy / sum_xx : best_scale;
+}
+#endif
+
+// Fits a single LED of the buffer being recalibrated, LEDs with fewer than
+// min_led_samples valid samples keep their scalar
+static void fit_led(SampleBuffer *buffer, int i)
+{
+    const DegradationParams *fit_params = &buffer->params;
+    int count = led_sample_counts[i];
+    if (count < fit_params->min_led_samples)
+    {
+        buffer->fit_stats.iterations[i] = 0;
+        buffer->fit_stats.fit_us[i] = 0;
+        return;
+    }
+
+    uint64_t start_us = time_us_64();
+    int iterations = 1;
+#ifdef DEGRADATION_ESTIMATOR_MEDIAN
+    float update = median_of_ratios(led_samples[i], led_references[i], count);
+#else
+    float update;
+    if (fit_params->ransac_confidence > 0.0f)
+    {
+        update = adaptive_fit(led_samples[i], led_references[i], count, fit_params, &iterations);
+    }
+    else
+    {
         // Fit the samples to the reference samples using RANSAC
-        float update = fit(
-            samples, reference_samples, sample_count, 0.1f, 25, 42);
-        scalars[i] *= update; // Ensure scalars do not decrease below 1.0
+        update = fit(
+            led_samples[i], led_references[i], count,
+            fit_params->ransac_threshold, fit_params->ransac_iterations, fit_params->ransac_seed);
+        iterations = fit_params->ransac_iterations;
     }
+#endif
+    next_scalars[i] *= update;
+
+    uint64_t fit_us = time_us_64() - start_us;
+    buffer->fit_stats.iterations[i] = (uint16_t)iterations;
+    buffer->fit_stats.fit_us[i] = fit_us < UINT16_MAX ? (uint16_t)fit_us : UINT16_MAX;
 }
 
-bool add_sample(float sample[TX_POSITIONS_COUNT], float x, float y)
+static bool refresh_due()
 {
-    // Copy the RSS sample to the buffer
-    memcpy(&sample_buffer_leds[sample_amount * TX_POSITIONS_COUNT], sample, sizeof(float) * TX_POSITIONS_COUNT);
-    // Store the position in the buffer
-    sample_buffer_positions[sample_amount * 2] = div_round_nearest(x, 10);
-    sample_buffer_positions[sample_amount * 2 + 1] = div_round_nearest(y, 10);
+    return window_count >= params.samples_per_update && cells_since_refresh >= params.refresh_interval;
+}
 
-    // Increment the sample count
-    sample_amount++;
+// Copies the newest samples_per_update samples, oldest first, and hands them to core1
+static void start_recalibration()
+{
+    int amount = params.samples_per_update;
+    int first = (window_head - amount + MAX_SAMPLES) % MAX_SAMPLES;
+    for (int j = 0; j < amount; j++)
+    {
+        int slot = (first + j) % MAX_SAMPLES;
+        memcpy(&fit_buffer.leds[j * TX_POSITIONS_COUNT], &window_leds[slot * TX_POSITIONS_COUNT],
+               sizeof(float) * TX_POSITIONS_COUNT);
+        fit_buffer.positions[j * 2] = window_positions[slot * 2];
+        fit_buffer.positions[j * 2 + 1] = window_positions[slot * 2 + 1];
+        fit_buffer.slots[j] = slot;
+    }
+    fit_buffer.amount = amount;
+    fit_buffer.params = params;
+    fit_buffer.generation = scalars_generation;
+    cells_since_refresh = 0;
+    fitting = true;
+
+    // Never fails, at most one buffer is ever in flight
+    SampleBuffer *buffer = &fit_buffer;
+    queue_try_add(&to_core1, &buffer);
+}
+
+// Returns the slot holding a cell, -1 if the window does not cover it. The
+// window is small enough that scanning it beats maintaining a lookup table.
+static int find_cell(int cell_x, int cell_y)
+{
+    for (int j = 0; j < window_count; j++)
+    {
+        int slot = (window_head - window_count + j + MAX_SAMPLES) % MAX_SAMPLES;
+        if (window_positions[slot * 2] == cell_x && window_positions[slot * 2 + 1] == cell_y)
+        {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+bool add_sample(const float sample[TX_POSITIONS_COUNT], float x, float y)
+{
+    int cell_x = div_round_nearest(x, 10);
+    int cell_y = div_round_nearest(y, 10);
+
+    // A cell already covered adds no coverage, fold the sample into its mean
+    int slot = find_cell(cell_x, cell_y);
+    if (slot >= 0)
+    {
+        if (window_weights[slot] < CELL_WEIGHT_CAP)
+        {
+            window_weights[slot]++;
+        }
+        float *mean = &window_leds[slot * TX_POSITIONS_COUNT];
+        for (int i = 0; i < TX_POSITIONS_COUNT; i++)
+        {
+            mean[i] += (sample[i] - mean[i]) / window_weights[slot];
+        }
+        return false;
+    }
+
+    // Copy the RSS sample to the window, replacing the oldest cell once it is full
+    memcpy(&window_leds[window_head * TX_POSITIONS_COUNT], sample, sizeof(float) * TX_POSITIONS_COUNT);
+    // Store the position in the window
+    window_positions[window_head * 2] = cell_x;
+    window_positions[window_head * 2 + 1] = cell_y;
+    window_weights[window_head] = 1;
+
+    window_head = (window_head + 1) % MAX_SAMPLES;
+    if (window_count < MAX_SAMPLES)
+    {
+        window_count++;
+    }
+    cells_since_refresh++;
+
+    // Refit if the window covers enough cells, enough new cells arrived and no fit is running
+    if (!refresh_due() || fitting)
+    {
+        return false;
+    }
+    start_recalibration();
+    return true;
+}
 
-    // Update scalars if we have enough samples
-    if (sample_amount < MAX_SAMPLES)
+bool recalibration_finished(uint32_t *elapsed_us)
+{
+    SampleBuffer *done;
+    if (!fitting || !queue_try_remove(&to_core0, &done))
     {
-        // Not enough samples to update scalars
         return false;
     }
-    update_scalars();
+
+    fitting = false;
+    *elapsed_us = done->elapsed_us;
+    bool published = done->published;
+    fit_stats = done->fit_stats;
+
+    // Enough new samples arrived while the previous recalibration was running
+    if (refresh_due())
+    {
+        start_recalibration();
+    }
+    return published;
+}
+
+bool recalibrate_step()
+{
+    if (!core1_buffer)
+    {
+        if (!queue_try_remove(&to_core1, &core1_buffer))
+        {
+            return false;
+        }
+        next_sample = 0;
+        next_led = 0;
+        memset(led_sample_counts, 0, sizeof(led_sample_counts));
+        memcpy(next_scalars, active_scalars, sizeof(next_scalars));
+        fit_start_us = time_us_64();
+    }
+
+    // One sample or one LED per call, so core1 can keep draining TX in between
+    if (next_sample < core1_buffer->amount)
+    {
+        add_references(core1_buffer, next_sample++);
+        return true;
+    }
+
+    fit_led(core1_buffer, next_led++);
+    if (next_led < TX_POSITIONS_COUNT)
+    {
+        return true;
+    }
+
+    // Publish all 36 at once, unless core0 replaced the scalars meanwhile
+    uint32_t save = spin_lock_blocking(scalars_lock);
+    core1_buffer->published = core1_buffer->generation == scalars_generation;
+    if (core1_buffer->published)
+    {
+        publish_scalars(next_scalars);
+    }
+    spin_unlock(scalars_lock, save);
+
+    core1_buffer->elapsed_us = (uint32_t)(time_us_64() - fit_start_us);
+    queue_try_add(&to_core0, &core1_buffer);
+    core1_buffer = NULL;
     return true;
 }
 
+static void estimator_init()
+{
+    queue_init(&to_core1, sizeof(SampleBuffer *), 1);
+    queue_init(&to_core0, sizeof(SampleBuffer *), 1);
+}
+
+static void estimator_scalars_replaced(const float new_scalars[TX_POSITIONS_COUNT])
+{
+    // The running fit, if any, is dropped through scalars_generation
+}
+
+static void estimator_samples_reset()
+{
+    window_count = 0;
+    cells_since_refresh = 0;
+}
+
+#endif // DEGRADATION_ESTIMATOR_RLS
+
+void degradation_model_init()
+{
+    scalars_lock = spin_lock_init(spin_lock_claim_unused(true));
+    estimator_init();
+}
+
 float *get_scalars()
 {
     // Return the current scalars
-    return scalars;
-}
\ No newline at end of file
+    return active_scalars;
+}
+
+void set_scalars(const float new_scalars[TX_POSITIONS_COUNT])
+{
+    // A running recalibration started from the old scalars, drop its result
+    uint32_t save = spin_lock_blocking(scalars_lock);
+    scalars_generation++;
+    publish_scalars(new_scalars);
+    spin_unlock(scalars_lock, save);
+    estimator_scalars_replaced(new_scalars);
+}
+
+void reset_samples()
+{
+    uint32_t save = spin_lock_blocking(scalars_lock);
+    scalars_generation++;
+    spin_unlock(scalars_lock, save);
+    estimator_samples_reset();
+}
+
+void get_led_fit_stats(LedFitStats *stats)
+{
+    *stats = fit_stats;
+}
+
+DegradationParams get_degradation_params()
+{
+    return params;
+}
+
+bool set_degradation_params(const DegradationParams *new_params)
+{
+    if (new_params->ransac_threshold <= 0.0f || new_params->ransac_iterations <= 0 ||
+        new_params->samples_per_update < 1 || new_params->samples_per_update > MAX_SAMPLES ||
+        new_params->refresh_interval < 1 || new_params->refresh_interval > MAX_SAMPLES ||
+        new_params->forgetting_factor <= 0.0f || new_params->forgetting_factor > 1.0f ||
+        new_params->ransac_confidence < 0.0f || new_params->ransac_confidence >= 1.0f ||
+        new_params->min_led_samples < 1 || new_params->min_led_samples > MAX_SAMPLES)
+    {
+        return false;
+    }
+
+    params = *new_params;
+    return true;
+}
@@ -3,6 +3,7 @@
 
 #include "../data/lambertian.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -13,19 +14,85 @@ extern "C"
 #define BUFFER_SIZE_LEDS (36 * MAX_SAMPLES)     // 36 LEDs * 50 samples per LED
 #define BUFFER_SIZE_POSITIONS (2 * MAX_SAMPLES) // 2D * 50 samples per LED
 
+#define DEFAULT_REFRESH_INTERVAL 10 // New samples between refits of the window
+#define DEFAULT_FORGETTING_FACTOR 0.98f // Weight of the past per new sample under RLS
+#define DEFAULT_RANSAC_CONFIDENCE 0.99f // Adaptive RANSAC stops once this sure of an inlier hypothesis
+#define DEFAULT_MIN_LED_SAMPLES 5       // Fewer valid samples leave an LED's scalar as it is
+
+// The scalars are estimated by a RANSAC fit over a sliding window of samples
+// on core1 (default, adaptive unless ransac_confidence is 0), or with DEGRADATION_ESTIMATOR_RLS by a Huber-weighted
+// recursive least squares update per sample on core0, which keeps no samples.
+// DEGRADATION_ESTIMATOR_MEDIAN keeps the window but fits each LED with the
+// median of reference / sample, which ignores the ransac_* parameters.
+
+typedef struct DegradationParams
+{
+    float ransac_threshold; // Inlier threshold passed to fit(), Huber threshold under RLS
+    int ransac_iterations;  // Iterations passed to fit()
+    int ransac_seed;        // Random seed passed to fit()
+    int samples_per_update; // Latest grid cells each recalibration fits, at most MAX_SAMPLES
+    int refresh_interval;   // Newly covered cells between recalibrations (samples under RLS), at most MAX_SAMPLES
+    float forgetting_factor; // RLS only, 0 < f <= 1, smaller forgets older samples faster
+    float ransac_confidence; // RANSAC only, 0 <= c < 1, 0 runs fit() for exactly ransac_iterations
+    int min_led_samples;     // Windowed fits only, 1..MAX_SAMPLES
+} DegradationParams;
+
+// Per LED, of the last recalibration collected by recalibration_finished()
+typedef struct LedFitStats
+{
+    uint16_t iterations[TX_POSITIONS_COUNT]; // RANSAC hypotheses tried, 1 for MEDIAN, 0 if skipped
+    uint16_t fit_us[TX_POSITIONS_COUNT];     // Time spent fitting on core1
+} LedFitStats;
+
+/**
+ * @brief Sets up the lock guarding the scalars, call before core1 is launched.
+ */
+void degradation_model_init();
+
 /**
- * @brief Adds a new RSS sample and its corresponding position to the internal buffer.
+ * @brief Adds a new RSS sample and its corresponding position to the sliding window.
  *
- * This function stores the provided RSS sample array and the 2D position (x, y).
- * When enough samples are collected (MAX_SAMPLES), it triggers an update of the
- * internal degradation scalars using a RANSAC-based fitting process.
+ * The window keeps one entry per (x / 10, y / 10) grid cell. A sample in a cell
+ * it already covers is merged into that cell's running mean, one in a new cell
+ * is stored with its position, evicting the oldest cell once MAX_SAMPLES are
+ * held. Once the window covers samples_per_update cells, every refresh_interval
+ * newly covered cells hand the latest samples_per_update cells to core1, which
+ * updates the internal degradation scalars in recalibrate_step(), so a receiver
+ * that stands still never triggers a recalibration. If a fit is still running the
+ * refresh starts as soon as it finishes. Under RLS the sample updates and publishes
+ * the scalars straight away instead, and every refresh_interval samples count as a
+ * finished recalibration. Must only be called from core0.
  *
- * @param sample A float array of 36 RSS values for the current sample.
+ * @param sample A float array of 36 RSS values as measured, before the scalars are applied.
  * @param x The x-coordinate of the current sample's position.
  * @param y The y-coordinate of the current sample's position.
- * @return true if the sample was added and scalars were updated, false if not enough samples yet.
+ * @return true if the sample started a recalibration, false otherwise.
+ */
+bool add_sample(const float sample[TX_POSITIONS_COUNT], float x, float y);
+
+/**
+ * @brief Collects a recalibration core1 has finished, on core0.
+ *
+ * Also hands core1 the next buffer if one filled up meanwhile.
+ *
+ * @param elapsed_us Set to the time core1 spent on the recalibration.
+ * @return true if a recalibration finished and published new scalars. Results
+ * of a recalibration cancelled by set_scalars() or reset_samples() are dropped.
+ */
+bool recalibration_finished(uint32_t *elapsed_us);
+
+/**
+ * @brief Advances the recalibration on core1 by one sample or one LED.
+ *
+ * Called in a loop on core1. The first calls resolve the reference RSS of one
+ * sample each, the following ones fit one LED each, so other core1 work can
+ * be interleaved. The new scalars replace the current ones in a single pointer
+ * swap once all LEDs are fitted, so get_scalars() never returns a mix of old
+ * and new values and never takes a lock.
+ *
+ * @return true if there was work to do.
  */
-bool add_sample(float sample[TX_POSITIONS_COUNT], float x, float y);
+bool recalibrate_step();
 
 /**
  * @brief Returns a pointer to the current array of degradation scalars.
@@ -38,6 +105,36 @@ bool add_sample(float sample[TX_POSITIONS_COUNT], float x, float y);
  */
 float *get_scalars();
 
+/**
+ * @brief Overwrites all degradation scalars, e.g. with values kept by the host.
+ *
+ * @param new_scalars A float array of TX_POSITIONS_COUNT scalars.
+ */
+void set_scalars(const float new_scalars[TX_POSITIONS_COUNT]);
+
+/**
+ * @brief Drops all samples collected since the last recalibration.
+ */
+void reset_samples();
+
+/**
+ * @brief Copies the per LED fit statistics, all zero under RLS. Core0 only.
+ */
+void get_led_fit_stats(LedFitStats *stats);
+
+/**
+ * @brief Returns a copy of the current recalibration parameters.
+ */
+DegradationParams get_degradation_params();
+
+/**
+ * @brief Replaces the recalibration parameters.
+ *
+ * @param new_params The parameters to use from the next recalibration on.
+ * @return false if a value is out of range, the old parameters are kept then.
+ */
+bool set_degradation_params(const DegradationParams *new_params);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,121 @@
+#include "event_loop.h"
+
+#include "../io/io.h"
+#include "../io/tx_queue.h"
+
+#include "pico/stdlib.h"
+
+#include <string.h>
+
+static EventHandler handlers[EVENT_TYPE_COUNT];
+static BackgroundTask tasks[EVENT_LOOP_MAX_TASKS];
+static int task_count = 0;
+static int next_task = 0;
+
+static uint32_t tick_period_us = 0; // 0 disables the tick
+static uint64_t next_tick_us = 0;
+
+static EventLoopStats stats;
+
+static inline void dispatch(EventType type)
+{
+    if (handlers[type])
+    {
+        handlers[type]();
+    }
+}
+
+// Gives one task a slice, returns true if it reported more work
+static bool run_background_slice(void)
+{
+    if (task_count == 0)
+    {
+        return false;
+    }
+
+    BackgroundTask task = tasks[next_task];
+    next_task = (next_task + 1) % task_count;
+
+    uint64_t start = time_us_64();
+    bool pending = task(EVENT_LOOP_SLICE_US);
+    uint32_t elapsed = (uint32_t)(time_us_64() - start);
+    if (elapsed > stats.max_background_slice_us)
+    {
+        stats.max_background_slice_us = elapsed;
+    }
+    return pending;
+}
+
+void event_loop_init(uint32_t tick_interval_us)
+{
+    memset(handlers, 0, sizeof(handlers));
+    memset(&stats, 0, sizeof(stats));
+    task_count = 0;
+    next_task = 0;
+    tick_period_us = tick_interval_us;
+    next_tick_us = time_us_64() + tick_interval_us;
+}
+
+void event_loop_on(EventType type, EventHandler handler)
+{
+    handlers[type] = handler;
+}
+
+bool event_loop_add_task(BackgroundTask task)
+{
+    if (task_count >= EVENT_LOOP_MAX_TASKS)
+    {
+        return false;
+    }
+    tasks[task_count++] = task;
+    return true;
+}
+
+void event_loop_step(void)
+{
+    io_poll(0);
+
+    // Requests first, but only when their response is guaranteed to fit
+    if (io_pending_requests() > 0)
+    {
+        if (tx_queue_free() >= IO_MAX_RESPONSE_BYTES)
+        {
+            uint64_t arrival_us = io_peek_request()->arrival_us;
+            dispatch(EVENT_PACKET_READY);
+
+            uint32_t latency = (uint32_t)(time_us_64() - arrival_us);
+            if (latency > stats.max_packet_latency_us)
+            {
+                stats.max_packet_latency_us = latency;
+            }
+            return;
+        }
+    }
+
+    uint64_t now = time_us_64();
+    if (tick_period_us > 0 && now >= next_tick_us)
+    {
+        next_tick_us = now + tick_period_us;
+        dispatch(EVENT_TIMER_TICK);
+        return;
+    }
+
+    // Background work only ever runs when no request can be served
+    if (!run_background_slice())
+    {
+        tight_loop_contents();
+    }
+}
+
+void event_loop_run(void)
+{
+    while (true)
+    {
+        event_loop_step();
+    }
+}
+
+void event_loop_get_stats(EventLoopStats *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,64 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EVENT_LOOP_MAX_TASKS 8
+#define EVENT_LOOP_SLICE_US 500 // Budget handed to a background task per turn
+
+typedef enum EventType
+{
+    EVENT_PACKET_READY, // A request is queued and the TX queue can take a response
+    EVENT_TIMER_TICK,   // The periodic tick configured in event_loop_init() elapsed
+    EVENT_TYPE_COUNT,
+} EventType;
+
+typedef void (*EventHandler)(void);
+
+/**
+ * @brief A cooperative background task.
+ *
+ * Tasks run only while no request is waiting and must return within roughly
+ * budget_us. They return true while they still have work pending.
+ */
+typedef bool (*BackgroundTask)(uint32_t budget_us);
+
+typedef struct EventLoopStats
+{
+    uint32_t max_packet_latency_us;  // Worst request arrival to handler completion
+    uint32_t max_background_slice_us; // Longest single background task turn
+} EventLoopStats;
+
+/**
+ * @brief Resets all handlers, tasks and statistics.
+ *
+ * @param tick_interval_us Period of EVENT_TIMER_TICK, 0 disables the tick.
+ */
+void event_loop_init(uint32_t tick_interval_us);
+
+/**
+ * @brief Registers the handler for an event, replacing any previous one.
+ */
+void event_loop_on(EventType type, EventHandler handler);
+
+/**
+ * @brief Adds a background task, run round robin when the loop is idle.
+ *
+ * @return false if EVENT_LOOP_MAX_TASKS are already registered.
+ */
+bool event_loop_add_task(BackgroundTask task);
+
+/**
+ * @brief Runs a single iteration of the loop, polling IO without blocking.
+ */
+void event_loop_step(void);
+
+/**
+ * @brief Runs the loop forever.
+ */
+void event_loop_run(void);
+
+void event_loop_get_stats(EventLoopStats *stats);
+
+#endif // EVENT_LOOP_H
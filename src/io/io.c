@@ -1,79 +1,349 @@
 #include "io.h"
+#include "parser.h"
+#include "transport.h"
+#include "tx_queue.h"
 
-#include "pico/stdio.h"
+#include "../telemetry/telemetry.h"
 
+#include "pico/time.h"
+
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+
+// Requests received but not answered yet, consumed in arrival order. The
+// extra slot lets a frame past the credit limit complete so the overload
+// policy can pick which one to shed.
+#define RX_SLOTS (VLP_MAX_OUTSTANDING + 1)
+static IncomingPacket rx_queue[RX_SLOTS];
+static int rx_head = 0;
+static int rx_count = 0;
+
+static VlpOverloadPolicy overload_policy = VLP_OVERLOAD_BLOCK;
+
+static PacketParser parser;
+
+// A partial frame that sees no bytes for this long is reported as a timeout.
+// It is kept, so a late arrival still completes it without losing alignment.
+#define IO_STALL_TIMEOUT_US 100000
+
+static uint64_t last_rx_us = 0;
+static bool stall_reported = false;
+
+// Bumped on every connect and disconnect of the link
+static uint32_t session = 0;
+static bool was_connected = false;
+
+bool io_connected(void)
+{
+    return transport_connected();
+}
+
+uint32_t io_session(void)
+{
+    return session;
+}
+
+void io_init(void)
+{
+    // Initialize the IO system
+    transport_init();
+    tx_queue_init();
+    rx_head = 0;
+    rx_count = 0;
+    parser_init(&parser);
+}
+
+static inline IncomingPacket *rx_slot(int index)
+{
+    return &rx_queue[(rx_head + index) % RX_SLOTS];
+}
+
+// Real-time frames, only these are ever shed
+static bool sheddable(const IncomingPacket *packet)
+{
+    switch (packet->opcode)
+    {
+    case VLP_OP_PREDICT:
+    case VLP_OP_BATCH_PREDICT:
+    case VLP_OP_PREDICT_ADC12:
+    case VLP_OP_PREDICT_ADC16:
+        return true;
+    default:
+        return false;
+    }
+}
 
-typedef union
+static inline int receiver_of(const IncomingPacket *packet)
 {
-    float f;
-    uint8_t b[4];
-} float_bytes_t;
+    return (packet->flags & VLP_FLAG_RECEIVER_MASK) >> VLP_FLAG_RECEIVER_SHIFT;
+}
 
-static void stdio_write_float_le(float value)
+// Copies the header and only the used part of the payload
+static void copy_request(IncomingPacket *dst, const IncomingPacket *src)
 {
-    float_bytes_t u;
-    u.f = value;
+    memcpy(dst, src, offsetof(IncomingPacket, payload));
+    memcpy(dst->payload, src->payload, src->len);
+}
 
-    for (int i = 0; i < 4; ++i)
+// Answers the request at index with DROPPED and closes the gap it leaves
+static void shed(int index, TelemetryCounter counter)
+{
+    write_error(rx_slot(index), VLP_ERROR_DROPPED);
+    telemetry_count(counter);
+    for (int i = index; i < rx_count - 1; i++)
     {
-        stdio_putchar_raw(u.b[i]);
+        copy_request(rx_slot(i), rx_slot(i + 1));
     }
+    rx_count--;
 }
 
-static int stdio_get_float_le_timeout_us(uint32_t timeout_us, float *value)
+// Called with the newest request already queued, brings the queue back within
+// the credit limit if it can
+static void apply_overload_policy(void)
 {
-    float_bytes_t u;
-    for (int i = 0; i < 4; ++i)
+    int newest = rx_count - 1;
+    IncomingPacket *packet = rx_slot(newest);
+    if (overload_policy == VLP_OVERLOAD_COALESCE && sheddable(packet))
+    {
+        for (int i = 0; i < newest; i++)
+        {
+            IncomingPacket *queued = rx_slot(i);
+            if (sheddable(queued) && receiver_of(queued) == receiver_of(packet))
+            {
+                // There is never more than one queued frame per receiver
+                shed(i, TELEMETRY_COALESCED);
+                return;
+            }
+        }
+    }
+
+    if (rx_count <= VLP_MAX_OUTSTANDING)
+    {
+        return;
+    }
+
+    if (overload_policy == VLP_OVERLOAD_DROP_NEWEST && sheddable(packet))
+    {
+        shed(newest, TELEMETRY_DROPPED_NEWEST);
+        return;
+    }
+
+    for (int i = 0; i < rx_count; i++)
     {
-        int c = stdio_getchar_timeout_us(timeout_us);
-        if (c == PICO_ERROR_TIMEOUT)
+        if (sheddable(rx_slot(i)))
         {
-            return PICO_ERROR_TIMEOUT;
+            shed(i, TELEMETRY_DROPPED_OLDEST);
+            return;
         }
-        u.b[i] = (uint8_t)c;
     }
-    *value = u.f;
-    return PICO_OK;
+    // Only control requests are queued, they are never shed, so reading
+    // stops until one of them is answered
 }
 
-void io_init(void)
+void io_set_overload_policy(VlpOverloadPolicy policy)
 {
-    // Initialize the IO system
-    stdio_init_all();
+    overload_policy = policy;
 }
 
-int read_packet(uint32_t timeout_ms, IncomingPacket *packet)
+int io_poll(uint32_t timeout_ms)
 {
-    // Read a packet from the IO system
-    int eval_char = stdio_getchar_timeout_us(timeout_ms * 1000);
-    if (eval_char == PICO_ERROR_TIMEOUT)
+    // Checked before reading, so every request is seen in its own session
+    bool connected = transport_connected();
+    if (connected != was_connected)
     {
-        return PICO_ERROR_TIMEOUT;
+        was_connected = connected;
+        session++;
     }
-    bool eval = (eval_char == 1);
 
-    IncomingPacket read_packet;
-    read_packet.eval = eval;
-    for (int i = 0; i < 36; i++)
+    uint64_t start_us = time_us_64();
+    uint64_t deadline_us = start_us + (uint64_t)timeout_ms * 1000;
+    bool any_bytes = false;
+    int received = 0;
+    // Blocking leaves excess requests in the transport, the other policies
+    // keep reading so they can shed them
+    int capacity = overload_policy == VLP_OVERLOAD_BLOCK ? VLP_MAX_OUTSTANDING : RX_SLOTS;
+    // Reading a request may answer it with an ERROR right away, only read while
+    // that reply is sure to fit, a dropped one would cost the host its credit
+    while (rx_count < capacity && tx_queue_free() >= IO_ERROR_RESPONSE_BYTES)
     {
-        float value;
-        int result = stdio_get_float_le_timeout_us(timeout_ms * 1000, &value);
-        if (result == PICO_ERROR_TIMEOUT)
+        // Parse straight out of the transport's receive buffer. The payload
+        // is still copied once, into its slot: handlers read it as aligned
+        // floats, and the transport gets the bytes back right away instead of
+        // holding them until the request is answered
+        const uint8_t *data;
+        size_t len = transport_rx_peek(&data);
+        if (len == 0)
         {
-            return PICO_ERROR_TIMEOUT;
+            // Only wait while nothing at all has arrived yet
+            if (!any_bytes && time_us_64() < deadline_us)
+            {
+                continue;
+            }
+            break;
+        }
+        any_bytes = true;
+
+        size_t consumed;
+        IncomingPacket *slot = rx_slot(rx_count);
+        ParserResult result = parser_feed(&parser, data, len, &consumed, slot);
+        transport_rx_consume(consumed);
+        if (result == PARSER_COMPLETE)
+        {
+            slot->arrival_us = time_us_64();
+            slot->inference_start_us = 0;
+            slot->inference_end_us = 0;
+            rx_count++;
+            received++;
+            telemetry_count(TELEMETRY_PACKETS_RECEIVED);
+            if (overload_policy != VLP_OVERLOAD_BLOCK)
+            {
+                apply_overload_policy();
+            }
+        }
+        else if (result == PARSER_ERROR)
+        {
+            // The payload never took a slot, answer right away
+            telemetry_count(TELEMETRY_PARSE_ERRORS);
+            slot->arrival_us = time_us_64();
+            slot->inference_start_us = 0;
+            slot->inference_end_us = 0;
+            write_error(slot, VLP_ERROR_BAD_LENGTH);
         }
-        read_packet.leds[i] = value;
     }
 
-    *packet = read_packet;
-    return PICO_OK;
+    uint64_t now = time_us_64();
+    if (any_bytes)
+    {
+        last_rx_us = now;
+        stall_reported = false;
+        telemetry_record(VLP_HISTOGRAM_IO_RX, (uint32_t)(now - start_us));
+    }
+    else if (!stall_reported && parser_in_frame(&parser) && now - last_rx_us > IO_STALL_TIMEOUT_US)
+    {
+        stall_reported = true;
+        telemetry_count(TELEMETRY_TIMEOUTS);
+    }
+    return received;
 }
 
-void write_packet(float x, float y)
+IncomingPacket *io_peek_request(void)
 {
-    // Write a packet to the IO system
-    stdio_write_float_le(x);
-    stdio_write_float_le(y);
-    stdio_flush();
+    if (rx_count == 0)
+    {
+        return NULL;
+    }
+    return &rx_queue[rx_head];
+}
+
+void io_pop_request(void)
+{
+    if (rx_count == 0)
+    {
+        return;
+    }
+    rx_head = (rx_head + 1) % RX_SLOTS;
+    rx_count--;
+}
+
+uint64_t io_last_rx_us(void)
+{
+    return last_rx_us;
+}
+
+int io_pending_requests(void)
+{
+    return rx_count;
+}
+
+static void fill_header(uint8_t header[VLP_RESPONSE_HEADER_SIZE], uint8_t type, uint8_t seq, uint16_t len)
+{
+    header[0] = type;
+    header[1] = seq;
+    header[2] = (uint8_t)(rx_count < VLP_MAX_OUTSTANDING ? VLP_MAX_OUTSTANDING - rx_count : 0);
+    header[3] = (uint8_t)(len & 0xFF);
+    header[4] = (uint8_t)(len >> 8);
+}
+
+// Frames the packet and hands it to the background transmitter
+static bool queue_frame(uint8_t type, uint8_t seq, const void *payload, uint16_t len)
+{
+    uint8_t header[VLP_RESPONSE_HEADER_SIZE];
+    fill_header(header, type, seq, len);
+    TxSpan spans[] = {{header, sizeof(header)}, {payload, len}};
+    return tx_queue_push_spans(spans, 2);
+}
+
+bool write_packet(uint8_t type, uint8_t seq, const void *payload, uint16_t len)
+{
+    return queue_frame(type | VLP_RESPONSE_UNSOLICITED, seq, payload, len);
+}
+
+bool write_reply(const IncomingPacket *request, uint8_t type, const void *payload, uint16_t len)
+{
+    if (!(request->flags & VLP_FLAG_TIMESTAMPS))
+    {
+        return queue_frame(type, request->seq, payload, len);
+    }
+
+    VlpTimestamps timestamps = {
+        .arrival_us = request->arrival_us,
+        .inference_start_us = request->inference_start_us,
+        .inference_end_us = request->inference_end_us,
+        .enqueue_us = time_us_64(),
+    };
+
+    uint8_t header[VLP_RESPONSE_HEADER_SIZE];
+    fill_header(header, type | VLP_RESPONSE_TIMESTAMPED, request->seq, (uint16_t)(len + sizeof(timestamps)));
+    TxSpan spans[] = {{header, sizeof(header)}, {payload, len}, {&timestamps, sizeof(timestamps)}};
+    return tx_queue_push_spans(spans, 3);
+}
+
+bool write_position(const IncomingPacket *request, float x, float y)
+{
+    float payload[2] = {x, y};
+    return write_reply(request, VLP_RESPONSE_POSITION, payload, sizeof(payload));
+}
+
+bool write_scalars(const IncomingPacket *request, const float scalars[VLP_LED_COUNT])
+{
+    return write_reply(request, VLP_RESPONSE_SCALARS, scalars, VLP_LED_COUNT * sizeof(float));
+}
+
+bool write_ack(const IncomingPacket *request)
+{
+    return write_reply(request, VLP_RESPONSE_ACK, NULL, 0);
+}
+
+bool write_error(const IncomingPacket *request, uint8_t error)
+{
+    return write_reply(request, VLP_RESPONSE_ERROR, &error, sizeof(error));
+}
+
+size_t io_tx_task(void)
+{
+    transport_task();
+
+    // Drain whatever is pending, this is the only place that writes to the transport
+    uint64_t start_us = time_us_64();
+    const uint8_t *data;
+    size_t total = 0;
+    size_t len;
+    while ((len = tx_queue_peek(&data)) > 0)
+    {
+        size_t written = transport_tx_write(data, len);
+        tx_queue_consume(written);
+        total += written;
+        if (written < len)
+        {
+            break; // Backend is busy, try again on the next call
+        }
+    }
+
+    if (total > 0)
+    {
+        transport_tx_flush();
+        telemetry_record(VLP_HISTOGRAM_IO_TX, (uint32_t)(time_us_64() - start_us));
+    }
+    return total;
 }
@@ -1,19 +1,84 @@
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "protocol.h"
+
 #ifndef IO_H
 #define IO_H
 
+// Upper bound on the bytes a single request produces, no reply payload is
+// larger than the largest request payload and at most two frames are sent
+#define IO_MAX_RESPONSE_BYTES \
+    (2 * (VLP_RESPONSE_HEADER_SIZE + sizeof(VlpTimestamps)) + VLP_MAX_PAYLOAD)
+
+// An ERROR reply, the most io_poll() itself sends per request it reads
+#define IO_ERROR_RESPONSE_BYTES (VLP_RESPONSE_HEADER_SIZE + 1 + sizeof(VlpTimestamps))
+
 typedef struct IncomingPacket
 {
-    bool eval;
-    float leds[36];
+    uint8_t opcode;
+    uint8_t flags;
+    uint8_t seq;
+    uint16_t len;
+    uint64_t arrival_us;         // time_us_64() when the last byte was parsed
+    uint64_t inference_start_us; // Filled in by handlers that run the model
+    uint64_t inference_end_us;
+    // Aligned so float payloads can be used in place
+    uint8_t payload[VLP_MAX_PAYLOAD] __attribute__((aligned(4)));
 } IncomingPacket;
 
+// The payload viewed as little-endian floats, the RP2040 shares the byte order
+static inline float *io_payload_floats(IncomingPacket *packet)
+{
+    return (float *)packet->payload;
+}
+
 void io_init(void);
 
-int read_packet(uint32_t timeout_us, IncomingPacket *packet);
+bool io_connected(void);
+
+// Changes whenever the link connects or disconnects, links that cannot tell
+// (UART) rely on VLP_FLAG_NEW_SESSION instead
+uint32_t io_session(void);
+
+// Feeds every byte the transport has already received into the request parser,
+// waiting up to timeout_ms for the first one. Partial frames are kept for the
+// next call. Reading pauses while the TX queue could not take an ERROR reply.
+// Returns the number of requests completed, including any the overload
+// policy shed.
+int io_poll(uint32_t timeout_ms);
+
+// Oldest unanswered request, NULL if none. The packet stays valid after
+// io_pop_request() until the next io_poll(), so handlers can release the
+// slot before answering and the reply advertises the freed credit.
+IncomingPacket *io_peek_request(void);
+
+void io_pop_request(void);
+
+int io_pending_requests(void);
+
+// time_us_64() when the transport last delivered bytes, 0 before the first
+uint64_t io_last_rx_us(void);
+
+// Selects what happens to real-time frames sent beyond the advertised credits
+void io_set_overload_policy(VlpOverloadPolicy policy);
+
+// Queues an unsolicited frame, not tied to a request, VLP_RESPONSE_UNSOLICITED
+// is set in its type
+bool write_packet(uint8_t type, uint8_t seq, const void *payload, uint16_t len);
+
+// Queues a reply to request, with timestamps appended when it asked for them
+bool write_reply(const IncomingPacket *request, uint8_t type, const void *payload, uint16_t len);
+
+bool write_position(const IncomingPacket *request, float x, float y);
+
+bool write_scalars(const IncomingPacket *request, const float scalars[VLP_LED_COUNT]);
+
+bool write_ack(const IncomingPacket *request);
+
+bool write_error(const IncomingPacket *request, uint8_t error);
 
-void write_packet(float x, float y);
+size_t io_tx_task(void);
 
-#endif // IO_H
\ No newline at end of file
+#endif // IO_H
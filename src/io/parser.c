@@ -0,0 +1,76 @@
+#include "parser.h"
+
+#include <string.h>
+
+static void enter_state(PacketParser *parser, ParserState state, size_t expected)
+{
+    parser->state = state;
+    parser->received = 0;
+    parser->expected = expected;
+}
+
+static void decode_header(const uint8_t *header, IncomingPacket *packet)
+{
+    packet->opcode = header[0];
+    packet->flags = header[1];
+    packet->seq = header[2];
+    packet->len = (uint16_t)(header[3] | (header[4] << 8));
+}
+
+void parser_init(PacketParser *parser)
+{
+    enter_state(parser, PARSER_STATE_HEADER, VLP_REQUEST_HEADER_SIZE);
+}
+
+bool parser_in_frame(const PacketParser *parser)
+{
+    return parser->state != PARSER_STATE_HEADER || parser->received > 0;
+}
+
+ParserResult parser_feed(PacketParser *parser, const uint8_t *data, size_t len, size_t *consumed, IncomingPacket *packet)
+{
+    size_t offset = 0;
+    while (true)
+    {
+        if (parser->received == parser->expected)
+        {
+            if (parser->state == PARSER_STATE_HEADER)
+            {
+                decode_header(parser->header, packet);
+                ParserState next = packet->len > VLP_MAX_PAYLOAD ? PARSER_STATE_DISCARD : PARSER_STATE_PAYLOAD;
+                enter_state(parser, next, packet->len);
+                continue; // A payload may be empty
+            }
+
+            ParserResult result = parser->state == PARSER_STATE_PAYLOAD ? PARSER_COMPLETE : PARSER_ERROR;
+            parser_init(parser);
+            *consumed = offset;
+            return result;
+        }
+
+        if (offset == len)
+        {
+            break;
+        }
+
+        size_t take = parser->expected - parser->received;
+        if (take > len - offset)
+        {
+            take = len - offset;
+        }
+
+        if (parser->state == PARSER_STATE_HEADER)
+        {
+            memcpy(&parser->header[parser->received], &data[offset], take);
+        }
+        else if (parser->state == PARSER_STATE_PAYLOAD)
+        {
+            memcpy(&packet->payload[parser->received], &data[offset], take);
+        }
+        parser->received += take;
+        offset += take;
+    }
+
+    *consumed = offset;
+    return PARSER_INCOMPLETE;
+}
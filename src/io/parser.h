@@ -0,0 +1,69 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "io.h"
+#include "protocol.h"
+
+#ifndef PARSER_H
+#define PARSER_H
+
+typedef enum ParserState
+{
+    PARSER_STATE_HEADER,
+    PARSER_STATE_PAYLOAD,
+    PARSER_STATE_DISCARD, // Skipping an oversized payload to stay aligned
+} ParserState;
+
+typedef enum ParserResult
+{
+    PARSER_INCOMPLETE, // All input consumed, the frame is still partial
+    PARSER_COMPLETE,   // A frame was completed into the packet
+    PARSER_ERROR,      // A frame was skipped, only the packet header is valid
+} ParserResult;
+
+/**
+ * @brief Incremental request parser.
+ *
+ * Bytes can be fed in arbitrarily sized chunks, the partial frame is kept
+ * across calls so a timeout in the middle of a frame never shifts the stream.
+ * The parser has no dependency on the pico SDK and can be built on the host.
+ */
+typedef struct PacketParser
+{
+    ParserState state;
+    size_t received; // Bytes received for the current state
+    size_t expected; // Bytes needed to finish the current state
+    uint8_t header[VLP_REQUEST_HEADER_SIZE];
+} PacketParser;
+
+/**
+ * @brief Resets the parser to wait for the start of a new frame.
+ */
+void parser_init(PacketParser *parser);
+
+/**
+ * @brief Returns true while part of a frame has been received.
+ */
+bool parser_in_frame(const PacketParser *parser);
+
+/**
+ * @brief Feeds a chunk of bytes into the parser.
+ *
+ * The payload is copied from data into packet, the one copy it takes on the
+ * device, so the same packet must be passed until the frame completes.
+ * Consumption stops right after a frame completes, the caller should feed the
+ * remaining bytes (data + *consumed) again once it has handled the packet.
+ *
+ * @param parser The parser state.
+ * @param data The incoming bytes.
+ * @param len The number of incoming bytes.
+ * @param consumed Set to the number of bytes consumed from data.
+ * @param packet Receives the frame.
+ * @return PARSER_COMPLETE if a frame was completed, PARSER_ERROR if a frame
+ *         with a payload larger than VLP_MAX_PAYLOAD was skipped, and
+ *         PARSER_INCOMPLETE otherwise.
+ */
+ParserResult parser_feed(PacketParser *parser, const uint8_t *data, size_t len, size_t *consumed, IncomingPacket *packet);
+
+#endif // PARSER_H
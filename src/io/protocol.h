@@ -0,0 +1,220 @@
+#include <stdint.h>
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// Wire format shared by the firmware and host tools.
+// All multi-byte fields are little-endian.
+
+#define VLP_LED_COUNT 36
+
+#define VLP_LED_BYTES (VLP_LED_COUNT * 4)
+
+// Raw photodiode ADC counts, converted to RSS on the device with the table
+// set by SET_ADC_CALIBRATION. 12-bit counts are packed two per 3 bytes:
+// [a7..a0][b3..b0 a11..a8][b11..b4]
+#define VLP_ADC12_BYTES (VLP_LED_COUNT * 3 / 2)
+#define VLP_ADC16_BYTES (VLP_LED_COUNT * 2)
+
+typedef struct __attribute__((packed)) VlpAdcCalibration
+{
+    float offset; // Count at zero light
+    float gain;   // RSS per count
+} VlpAdcCalibration;
+
+// Number of unanswered requests the device buffers. The host may keep at most
+// this many requests in flight, every request is answered by exactly one
+// reply (see VlpOpcode) which returns its slot.
+#define VLP_MAX_OUTSTANDING 8
+
+// Largest BATCH_PREDICT and the payload size it implies
+#define VLP_MAX_BATCH 8
+#define VLP_MAX_PAYLOAD (VLP_MAX_BATCH * VLP_LED_BYTES)
+
+// Request: [opcode u8][flags u8][seq u8][len u16][len bytes of payload]
+// Unused flag bits must be 0.
+#define VLP_REQUEST_HEADER_SIZE 5
+
+#define VLP_FLAG_TIMESTAMPS 0x01 // Append VlpTimestamps to the reply
+#define VLP_FLAG_NEW_SESSION 0x02 // A new host starts here, resets per-session state before handling the request
+
+// Receiver a real-time frame belongs to, 0..15, used by VLP_OVERLOAD_COALESCE
+#define VLP_FLAG_RECEIVER_SHIFT 4
+#define VLP_FLAG_RECEIVER_MASK 0xF0
+
+// Response: [type u8][seq u8][credits u8][len u16][len bytes of payload]
+// seq echoes the request being answered, credits is the number of request
+// slots free on the device once this response was queued.
+#define VLP_RESPONSE_HEADER_SIZE 5
+
+// Set in the type byte when the last sizeof(VlpTimestamps) bytes of the
+// payload are device timestamps, in reply to VLP_FLAG_TIMESTAMPS
+#define VLP_RESPONSE_TIMESTAMPED 0x80
+
+// Set in the type byte of frames that answer no request, e.g. periodic
+// telemetry. Their seq shares the request seq space, so hosts must route on
+// this bit and never match such a frame to an outstanding request.
+#define VLP_RESPONSE_UNSOLICITED 0x40
+
+// time_us_64() on the device at each stage of handling a request. The
+// inference fields are 0 for requests that do not run the model.
+typedef struct __attribute__((packed)) VlpTimestamps
+{
+    uint64_t arrival_us;         // Last byte of the request parsed
+    uint64_t inference_start_us; // First inference started
+    uint64_t inference_end_us;   // Last inference finished
+    uint64_t enqueue_us;         // Reply handed to the TX queue
+} VlpTimestamps;
+
+typedef enum VlpOpcode
+{
+    VLP_OP_CALIBRATE_SAMPLE = 0,     // 36 x f32 -> POSITION, unsolicited SCALARS with its seq once a recalibration it started finishes
+    VLP_OP_PREDICT = 1,              // 36 x f32 -> POSITION
+    VLP_OP_GET_SCALARS = 2,          // none -> SCALARS, also the baseline later SCALAR_DELTAs refer to
+    VLP_OP_SET_SCALARS = 3,          // 36 x f32 -> ACK
+    VLP_OP_SET_PARAM = 4,            // [param u8][value f32] -> ACK
+    VLP_OP_GET_STATS = 5,            // none -> TELEMETRY
+    VLP_OP_RESET_BUFFER = 6,         // none -> ACK, empties the calibration cell window
+    VLP_OP_BATCH_PREDICT = 7,        // 1..VLP_MAX_BATCH x (36 x f32) -> POSITIONS
+    VLP_OP_ECHO = 8,                 // 0..VLP_MAX_PAYLOAD bytes -> ECHO with the same bytes
+    VLP_OP_REPLAY_LOAD = 9,          // [first u16][1..VLP_REPLAY_CHUNK x VlpReplayFrame] -> ACK
+    VLP_OP_REPLAY_RUN = 10,          // [count u16] -> REPLAY_STATS over frames 0..count-1
+    VLP_OP_REPLAY_READ = 11,         // [first u16][count u16] -> POSITIONS predicted by the last run
+    VLP_OP_PREDICT_ADC12 = 12,       // 36 x 12-bit packed counts -> POSITION
+    VLP_OP_PREDICT_ADC16 = 13,       // 36 x u16 counts -> POSITION
+    VLP_OP_SET_ADC_CALIBRATION = 14, // 36 x VlpAdcCalibration -> ACK
+    VLP_OP_GET_ADC_CALIBRATION = 15, // none -> ADC_CALIBRATION
+    VLP_OPCODE_COUNT,
+} VlpOpcode;
+
+typedef enum VlpParam
+{
+    VLP_PARAM_RANSAC_THRESHOLD = 0,   // Inlier threshold of the scalar fit
+    VLP_PARAM_RANSAC_ITERATIONS = 1,  // Iterations of the scalar fit
+    VLP_PARAM_RANSAC_SEED = 2,        // Random seed of the scalar fit
+    VLP_PARAM_SAMPLES_PER_UPDATE = 3, // Latest covered 10x10 cells each recalibration fits, 1..50
+    VLP_PARAM_TELEMETRY_PERIOD_MS = 4, // Unsolicited telemetry interval, 0 disables it
+    VLP_PARAM_LOOPBACK = 5,           // 1 answers every request except SET_PARAM with ECHO
+    VLP_PARAM_OVERLOAD_POLICY = 6,    // VlpOverloadPolicy
+    VLP_PARAM_REFRESH_INTERVAL = 7,   // Newly covered cells between recalibrations, 1..50
+    VLP_PARAM_FORGETTING_FACTOR = 8,  // Streaming (RLS) scalar estimator only, 0 < f <= 1
+    VLP_PARAM_RANSAC_CONFIDENCE = 9,  // Early termination target of the scalar fit, 0 always runs all iterations
+    VLP_PARAM_MIN_LED_SAMPLES = 10,   // Valid samples an LED needs to be refitted, 1..50
+    VLP_PARAM_SCALAR_DELTAS = 11,     // 1 sends SCALAR_DELTA instead of SCALARS after a recalibration, per session
+    VLP_PARAM_SCALAR_EPSILON = 12,    // Smallest change a SCALAR_DELTA reports, >= 0
+    VLP_PARAM_COUNT,
+} VlpParam;
+
+// What the device does with real-time frames (PREDICT, BATCH_PREDICT and
+// PREDICT_ADC12/16) once the host sends more than its credits allow. Every
+// other request is always kept. Shed frames are answered with ERROR(DROPPED).
+typedef enum VlpOverloadPolicy
+{
+    VLP_OVERLOAD_BLOCK = 0,       // Stop reading until a slot frees up, the transport buffers the rest
+    VLP_OVERLOAD_DROP_OLDEST = 1, // Shed the oldest queued frame to make room
+    VLP_OVERLOAD_DROP_NEWEST = 2, // Shed the frame that just arrived
+    VLP_OVERLOAD_COALESCE = 3,    // Keep only the latest frame per receiver, else drop the oldest
+    VLP_OVERLOAD_POLICY_COUNT,
+} VlpOverloadPolicy;
+
+typedef enum VlpResponseType
+{
+    VLP_RESPONSE_POSITION = 0,        // Payload: x f32, y f32 (NaN on failure)
+    VLP_RESPONSE_SCALARS = 1,         // Payload: 36 x f32
+    VLP_RESPONSE_TELEMETRY = 2,       // Payload: VlpTelemetryReport, seq is 0 when unsolicited
+    VLP_RESPONSE_ACK = 3,             // No payload
+    VLP_RESPONSE_ERROR = 4,           // Payload: VlpError u8
+    VLP_RESPONSE_POSITIONS = 5,       // Payload: n x (x f32, y f32), one per batched frame
+    VLP_RESPONSE_ECHO = 6,            // Payload: the request payload
+    VLP_RESPONSE_REPLAY_STATS = 7,    // Payload: VlpReplayStats
+    VLP_RESPONSE_ADC_CALIBRATION = 8, // Payload: 36 x VlpAdcCalibration
+    VLP_RESPONSE_SCALAR_DELTA = 9,    // Payload: [count u8][count x VlpScalarDelta]
+} VlpResponseType;
+
+// With SCALAR_DELTAS on, a finished recalibration only reports the scalars
+// that moved by more than SCALAR_EPSILON from what the host was last sent,
+// so the host's copy never lags by more than that. The device sends full
+// SCALARS instead until the host has a baseline, i.e. after GET_SCALARS or
+// SET_SCALARS in the current session, and GET_SCALARS resyncs at any time.
+// SCALAR_DELTAS and the baseline are per session: both are reset when the
+// USB link connects or disconnects and by a request with VLP_FLAG_NEW_SESSION,
+// which a host sharing a UART link must set on its first request.
+typedef struct __attribute__((packed)) VlpScalarDelta
+{
+    uint8_t index; // LED, 0..35
+    float value;
+} VlpScalarDelta;
+
+typedef enum VlpError
+{
+    VLP_ERROR_UNKNOWN_OPCODE = 1,
+    VLP_ERROR_BAD_LENGTH = 2, // Payload length does not fit the opcode
+    VLP_ERROR_BAD_PARAM = 3,  // Unknown parameter or value out of range
+    VLP_ERROR_DROPPED = 4,    // Shed by the overload policy without being processed
+} VlpError;
+
+// Frames the device holds for offline evaluation, uploaded in chunks with
+// REPLAY_LOAD, run in one go with REPLAY_RUN and read back with REPLAY_READ
+#define VLP_REPLAY_FRAMES 256
+
+typedef struct __attribute__((packed)) VlpReplayFrame
+{
+    float leds[VLP_LED_COUNT];
+    float x; // Ground truth position
+    float y;
+} VlpReplayFrame;
+
+// Frames per REPLAY_LOAD and predictions per REPLAY_READ
+#define VLP_REPLAY_CHUNK ((VLP_MAX_PAYLOAD - 2) / sizeof(VlpReplayFrame))
+#define VLP_REPLAY_READ_CHUNK (VLP_MAX_PAYLOAD / (2 * sizeof(float)))
+
+// Errors are Euclidean distances between prediction and ground truth, frames
+// whose inference failed are only counted in failures
+typedef struct __attribute__((packed)) VlpReplayStats
+{
+    uint32_t frames;
+    uint32_t failures;
+    uint32_t elapsed_us; // Inference over the whole block, no link time
+    float mean_error;
+    float rms_error;
+    float p50_error;
+    float p95_error;
+    float max_error;
+} VlpReplayStats;
+
+// Histogram bucket i counts durations below 2^i us, the last bucket is open ended
+#define VLP_TELEMETRY_BUCKETS 16
+
+typedef enum VlpTelemetryHistogram
+{
+    VLP_HISTOGRAM_INFERENCE,
+    VLP_HISTOGRAM_RECALIBRATION, // Whole recalibration on core1, recorded once it is collected
+    VLP_HISTOGRAM_IO_RX, // Parsing received bytes on core0
+    VLP_HISTOGRAM_IO_TX, // Draining the TX queue on core1
+    VLP_HISTOGRAM_COUNT,
+} VlpTelemetryHistogram;
+
+typedef struct __attribute__((packed)) VlpTelemetryReport
+{
+    uint32_t uptime_ms;
+    uint32_t packets_received;
+    uint32_t packets_answered;
+    uint32_t parse_errors;
+    uint32_t timeouts; // Partial frames that stalled for longer than the IO timeout
+    uint32_t histograms[VLP_HISTOGRAM_COUNT][VLP_TELEMETRY_BUCKETS];
+    uint32_t max_packet_latency_us;
+    uint32_t max_background_slice_us;
+    uint16_t rx_pending;
+    uint16_t tx_pending;
+    uint32_t tx_high_water_mark;
+    uint32_t tx_dropped_frames;
+    uint32_t arena_free_bytes;
+    uint32_t stack_free_bytes;
+    uint32_t dropped_oldest; // Frames shed by the overload policy, see VlpOverloadPolicy
+    uint32_t dropped_newest;
+    uint32_t coalesced;
+    uint16_t fit_iterations[VLP_LED_COUNT]; // Per LED, last recalibration, 0 if it had too few samples
+    uint16_t fit_us[VLP_LED_COUNT];
+} VlpTelemetryReport;
+
+#endif // PROTOCOL_H
@@ -0,0 +1,49 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+// Byte transport underneath io.c. Exactly one backend is compiled in, chosen
+// with the VLP_TRANSPORT CMake option (VLP_TRANSPORT_<NAME> is defined).
+//
+// RX is exposed as spans of the backend's own receive buffer so the parser
+// can read straight out of it. RX functions are only called from core0 and
+// TX functions only from core1. Backends whose stack must stay on one core
+// (USB vendor) start it from transport_task() and report connected from there.
+
+void transport_init(void);
+
+bool transport_connected(void);
+
+/**
+ * @brief Returns the oldest received bytes without copying them.
+ *
+ * The span is contiguous and stays valid until transport_rx_consume().
+ *
+ * @param data Set to the start of the received bytes.
+ * @return Number of bytes available in the span, 0 if nothing was received.
+ */
+size_t transport_rx_peek(const uint8_t **data);
+
+void transport_rx_consume(size_t len);
+
+/**
+ * @brief Starts sending bytes without blocking.
+ *
+ * @return Number of bytes accepted, the caller may release them right away.
+ */
+size_t transport_tx_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Pushes out any bytes the backend is still holding back.
+ */
+void transport_tx_flush(void);
+
+/**
+ * @brief Services the backend, called continuously from core1.
+ */
+void transport_task(void);
+
+#endif // TRANSPORT_H
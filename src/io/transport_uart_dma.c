@@ -0,0 +1,129 @@
+#ifdef VLP_TRANSPORT_UART_DMA
+
+#include "transport.h"
+#include "protocol.h"
+
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/uart.h"
+
+#include <string.h>
+
+#ifndef VLP_UART_BAUD
+#define VLP_UART_BAUD 3000000
+#endif
+
+#ifndef VLP_UART_TX_PIN
+#define VLP_UART_TX_PIN 0
+#endif
+
+#ifndef VLP_UART_RX_PIN
+#define VLP_UART_RX_PIN 1
+#endif
+
+#define VLP_UART uart0
+
+// The ring has no flow control and the framing no resync marker, so it must
+// hold every request the host's credits allow, at their largest, while core0
+// is busy elsewhere. Credits keep the host from lapping the read side then.
+#define RX_RING_BITS 14
+#define RX_RING_SIZE (1u << RX_RING_BITS)
+#define RX_RING_MASK (RX_RING_SIZE - 1)
+
+_Static_assert(RX_RING_SIZE > VLP_MAX_OUTSTANDING * (VLP_REQUEST_HEADER_SIZE + VLP_MAX_PAYLOAD),
+               "RX ring must hold every outstanding request at its largest");
+_Static_assert(RX_RING_BITS <= 15, "DMA ring wrap supports at most 32 KiB");
+#define TX_BUFFER_SIZE 512
+
+// The DMA ring wrap requires the buffer to be aligned to its size
+static uint8_t rx_ring[RX_RING_SIZE] __attribute__((aligned(RX_RING_SIZE)));
+static uint32_t rx_read = 0;
+
+static uint8_t tx_buffer[TX_BUFFER_SIZE];
+
+static int rx_channel;
+static int tx_channel;
+
+static inline uint32_t rx_write_offset(void)
+{
+    return (dma_channel_hw_addr(rx_channel)->write_addr - (uintptr_t)rx_ring) & RX_RING_MASK;
+}
+
+void transport_init(void)
+{
+    uart_init(VLP_UART, VLP_UART_BAUD);
+    gpio_set_function(VLP_UART_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(VLP_UART_RX_PIN, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(VLP_UART, true);
+
+    // RX: the channel writes forever into the ring, software only tracks the read side
+    rx_channel = dma_claim_unused_channel(true);
+    dma_channel_config rx_config = dma_channel_get_default_config(rx_channel);
+    channel_config_set_transfer_data_size(&rx_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&rx_config, false);
+    channel_config_set_write_increment(&rx_config, true);
+    channel_config_set_ring(&rx_config, true, RX_RING_BITS);
+    channel_config_set_dreq(&rx_config, uart_get_dreq(VLP_UART, false));
+    dma_channel_configure(rx_channel, &rx_config, rx_ring, &uart_get_hw(VLP_UART)->dr, 0xFFFFFFFF, true);
+
+    tx_channel = dma_claim_unused_channel(true);
+    dma_channel_config tx_config = dma_channel_get_default_config(tx_channel);
+    channel_config_set_transfer_data_size(&tx_config, DMA_SIZE_8);
+    channel_config_set_read_increment(&tx_config, true);
+    channel_config_set_write_increment(&tx_config, false);
+    channel_config_set_dreq(&tx_config, uart_get_dreq(VLP_UART, true));
+    dma_channel_configure(tx_channel, &tx_config, &uart_get_hw(VLP_UART)->dr, tx_buffer, 0, false);
+}
+
+bool transport_connected(void)
+{
+    return true;
+}
+
+size_t transport_rx_peek(const uint8_t **data)
+{
+    // Re-arm after 4G bytes, the write address carries on where it stopped
+    if (!dma_channel_is_busy(rx_channel))
+    {
+        dma_channel_set_trans_count(rx_channel, 0xFFFFFFFF, true);
+    }
+
+    uint32_t write = rx_write_offset();
+    uint32_t span = write >= rx_read ? write - rx_read : RX_RING_SIZE - rx_read;
+
+    *data = &rx_ring[rx_read];
+    return span;
+}
+
+void transport_rx_consume(size_t len)
+{
+    rx_read = (rx_read + len) & RX_RING_MASK;
+}
+
+size_t transport_tx_write(const uint8_t *data, size_t len)
+{
+    if (dma_channel_is_busy(tx_channel))
+    {
+        return 0;
+    }
+
+    if (len > TX_BUFFER_SIZE)
+    {
+        len = TX_BUFFER_SIZE;
+    }
+    memcpy(tx_buffer, data, len);
+    dma_channel_transfer_from_buffer_now(tx_channel, tx_buffer, len);
+    return len;
+}
+
+void transport_tx_flush(void)
+{
+    // Nothing is held back, the DMA channel sends as soon as it is started
+}
+
+void transport_task(void)
+{
+    // Both directions are serviced by DMA
+}
+
+#endif // VLP_TRANSPORT_UART_DMA
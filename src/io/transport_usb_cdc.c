@@ -0,0 +1,70 @@
+#ifdef VLP_TRANSPORT_USB_CDC
+
+#include "transport.h"
+
+#include "pico/stdio.h"
+#include "pico/stdio_usb.h"
+
+// stdio only hands out single characters, stage them so the parser sees spans
+#define RX_STAGING_SIZE 64
+
+static uint8_t rx_staging[RX_STAGING_SIZE];
+static size_t rx_start = 0;
+static size_t rx_end = 0;
+
+void transport_init(void)
+{
+    stdio_init_all();
+}
+
+bool transport_connected(void)
+{
+    return stdio_usb_connected();
+}
+
+size_t transport_rx_peek(const uint8_t **data)
+{
+    if (rx_start == rx_end)
+    {
+        rx_start = 0;
+        rx_end = 0;
+        while (rx_end < RX_STAGING_SIZE)
+        {
+            int c = stdio_getchar_timeout_us(0);
+            if (c == PICO_ERROR_TIMEOUT)
+            {
+                break;
+            }
+            rx_staging[rx_end++] = (uint8_t)c;
+        }
+    }
+
+    *data = &rx_staging[rx_start];
+    return rx_end - rx_start;
+}
+
+void transport_rx_consume(size_t len)
+{
+    rx_start += len;
+}
+
+size_t transport_tx_write(const uint8_t *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        stdio_putchar_raw(data[i]);
+    }
+    return len;
+}
+
+void transport_tx_flush(void)
+{
+    stdio_flush();
+}
+
+void transport_task(void)
+{
+    // stdio_usb services the device from its own background IRQ
+}
+
+#endif // VLP_TRANSPORT_USB_CDC
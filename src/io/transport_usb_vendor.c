@@ -0,0 +1,116 @@
+#ifdef VLP_TRANSPORT_USB_VENDOR
+
+#include "transport.h"
+
+#include "hardware/sync.h"
+#include "tusb.h"
+
+// TinyUSB is not safe to call from two cores, its OS_NONE port only masks the
+// USB IRQ on the calling core. Everything TinyUSB, including tusb_init() so the
+// IRQ lands on core1 too, runs from transport_task(). Received bytes reach
+// core0 through a single-producer, single-consumer ring, the mirror image of
+// tx_queue.
+
+// Several full bulk packets, the OUT endpoint NAKs while the ring is full
+#define RX_RING_SIZE (16 * VLP_USB_BULK_PACKET_SIZE)
+#define RX_RING_MASK (RX_RING_SIZE - 1)
+
+_Static_assert((RX_RING_SIZE & RX_RING_MASK) == 0, "RX ring size must be a power of two");
+
+// head is only written by core1 and tail only by core0, both free-running
+static uint8_t rx_ring[RX_RING_SIZE];
+static volatile uint32_t rx_head = 0;
+static volatile uint32_t rx_tail = 0;
+
+static bool started = false;
+static volatile bool mounted = false;
+
+void transport_init(void)
+{
+    // Runs on core0, TinyUSB itself is started by core1 in transport_task()
+    rx_head = 0;
+    rx_tail = 0;
+}
+
+bool transport_connected(void)
+{
+    return mounted;
+}
+
+size_t transport_rx_peek(const uint8_t **data)
+{
+    uint32_t t = rx_tail;
+    uint32_t pending = rx_head - t;
+    __dmb();
+
+    uint32_t offset = t & RX_RING_MASK;
+    size_t span = RX_RING_SIZE - offset;
+    if (span > pending)
+    {
+        span = pending;
+    }
+    *data = &rx_ring[offset];
+    return span;
+}
+
+void transport_rx_consume(size_t len)
+{
+    // Finish parsing the span before handing the space back to core1
+    __dmb();
+    rx_tail = rx_tail + len;
+}
+
+size_t transport_tx_write(const uint8_t *data, size_t len)
+{
+    return tud_vendor_write(data, len);
+}
+
+void transport_tx_flush(void)
+{
+    tud_vendor_write_flush();
+}
+
+// Moves whatever the OUT endpoint delivered into the ring, as far as it fits
+static void pull_rx(void)
+{
+    uint32_t h = rx_head;
+    uint32_t free = RX_RING_SIZE - (h - rx_tail);
+    while (free > 0 && tud_vendor_available() > 0)
+    {
+        uint32_t offset = h & RX_RING_MASK;
+        uint32_t span = RX_RING_SIZE - offset;
+        if (span > free)
+        {
+            span = free;
+        }
+
+        uint32_t read = tud_vendor_read(&rx_ring[offset], span);
+        if (read == 0)
+        {
+            break;
+        }
+        h += read;
+        free -= read;
+    }
+
+    // Make the bytes visible to core0 before publishing the new head
+    __dmb();
+    rx_head = h;
+}
+
+void transport_task(void)
+{
+    // Runs on core1 next to the TX drain, so enumeration and bulk transfers
+    // keep going while core0 is busy with inference
+    if (!started)
+    {
+        tusb_init();
+        started = true;
+    }
+
+    tud_task();
+    mounted = tud_mounted();
+    pull_rx();
+}
+
+#endif // VLP_TRANSPORT_USB_VENDOR
@@ -0,0 +1,114 @@
+#include "tx_queue.h"
+
+#include "hardware/sync.h"
+
+#include <string.h>
+
+#define TX_QUEUE_MASK (TX_QUEUE_SIZE - 1)
+
+// Single-producer, single-consumer ring. head is only written by the producer
+// and tail only by the consumer, both are free-running and masked on access.
+static uint8_t buffer[TX_QUEUE_SIZE];
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+static TxQueueStats stats = {0};
+
+void tx_queue_init(void)
+{
+    head = 0;
+    tail = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+size_t tx_queue_free(void)
+{
+    return TX_QUEUE_SIZE - (head - tail);
+}
+
+// Copies len bytes into the ring starting at the free-running index pos
+static void copy_in(uint32_t pos, const uint8_t *data, size_t len)
+{
+    if (len == 0)
+    {
+        return;
+    }
+
+    uint32_t offset = pos & TX_QUEUE_MASK;
+    size_t first = TX_QUEUE_SIZE - offset;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(&buffer[offset], data, first);
+    memcpy(buffer, data + first, len - first);
+}
+
+bool tx_queue_push_spans(const TxSpan *spans, int count)
+{
+    size_t len = 0;
+    for (int i = 0; i < count; i++)
+    {
+        len += spans[i].len;
+    }
+
+    uint32_t h = head;
+    uint32_t used = h - tail;
+    if (len > TX_QUEUE_SIZE - used)
+    {
+        stats.dropped_frames++;
+        stats.dropped_bytes += len;
+        return false;
+    }
+
+    uint32_t pos = h;
+    for (int i = 0; i < count; i++)
+    {
+        copy_in(pos, spans[i].data, spans[i].len);
+        pos += spans[i].len;
+    }
+
+    // Make the payload visible to the consumer before publishing the new head
+    __dmb();
+    head = h + len;
+
+    used += len;
+    if (used > stats.high_water_mark)
+    {
+        stats.high_water_mark = used;
+    }
+    return true;
+}
+
+size_t tx_queue_pending(void)
+{
+    return head - tail;
+}
+
+size_t tx_queue_peek(const uint8_t **data)
+{
+    uint32_t t = tail;
+    uint32_t pending = head - t;
+    __dmb();
+
+    uint32_t offset = t & TX_QUEUE_MASK;
+    size_t span = TX_QUEUE_SIZE - offset;
+    if (span > pending)
+    {
+        span = pending;
+    }
+    *data = &buffer[offset];
+    return span;
+}
+
+void tx_queue_consume(size_t len)
+{
+    // Finish reading the span before handing the space back to the producer
+    __dmb();
+    tail = tail + len;
+}
+
+void tx_queue_get_stats(TxQueueStats *out)
+{
+    *out = stats;
+}
@@ -0,0 +1,72 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TX_QUEUE_H
+#define TX_QUEUE_H
+
+#define TX_QUEUE_SIZE 4096 // Bytes, must be a power of two
+
+typedef struct TxSpan
+{
+    const void *data;
+    size_t len;
+} TxSpan;
+
+typedef struct TxQueueStats
+{
+    uint32_t high_water_mark; // Largest number of bytes ever pending
+    uint32_t dropped_frames;  // Frames rejected because the queue was full
+    uint32_t dropped_bytes;   // Bytes belonging to the rejected frames
+} TxQueueStats;
+
+/**
+ * @brief Resets the transmit queue and its statistics.
+ */
+void tx_queue_init(void);
+
+/**
+ * @brief Enqueues a frame gathered from several spans, e.g. header and payload.
+ *
+ * The frame is either queued in full or dropped in full, so the host never
+ * sees a truncated frame, and the caller never has to assemble it in a
+ * temporary buffer first. Only a single producer (core0) may call this.
+ *
+ * @param spans The pieces of the frame, in order.
+ * @param count Number of spans.
+ * @return true if the frame was queued, false if it was dropped.
+ */
+bool tx_queue_push_spans(const TxSpan *spans, int count);
+
+/**
+ * @brief Returns the number of bytes that can currently be enqueued.
+ */
+size_t tx_queue_free(void);
+
+/**
+ * @brief Returns the number of bytes waiting to be sent.
+ */
+size_t tx_queue_pending(void);
+
+/**
+ * @brief Returns a pointer to the oldest pending bytes.
+ *
+ * Only a single consumer may call this. The returned span is contiguous and
+ * may be shorter than the total number of pending bytes when the data wraps.
+ *
+ * @param data Set to the start of the pending span.
+ * @return Length of the span, 0 if the queue is empty.
+ */
+size_t tx_queue_peek(const uint8_t **data);
+
+/**
+ * @brief Releases bytes previously returned by tx_queue_peek().
+ */
+void tx_queue_consume(size_t len);
+
+/**
+ * @brief Copies the current queue statistics.
+ */
+void tx_queue_get_stats(TxQueueStats *stats);
+
+#endif // TX_QUEUE_H
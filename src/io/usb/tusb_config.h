@@ -0,0 +1,28 @@
+#ifndef TUSB_CONFIG_H
+#define TUSB_CONFIG_H
+
+// TinyUSB configuration for the USB_VENDOR transport. Only on the include
+// path when VLP_TRANSPORT is USB_VENDOR, stdio_usb brings its own otherwise.
+
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+
+#ifndef CFG_TUSB_MEM_ALIGN
+#define CFG_TUSB_MEM_ALIGN __attribute__((aligned(4)))
+#endif
+
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_CDC 0
+#define CFG_TUD_MSC 0
+#define CFG_TUD_HID 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 1
+
+// Full-speed bulk endpoints carry at most 64 bytes per packet
+#define VLP_USB_BULK_PACKET_SIZE 64
+
+// Room for several queued requests in each direction
+#define CFG_TUD_VENDOR_RX_BUFSIZE 1024
+#define CFG_TUD_VENDOR_TX_BUFSIZE 1024
+
+#endif // TUSB_CONFIG_H
@@ -0,0 +1,104 @@
+#ifdef VLP_TRANSPORT_USB_VENDOR
+
+#include "tusb.h"
+
+#include <string.h>
+
+// Development IDs, override for production hardware
+#ifndef VLP_USB_VID
+#define VLP_USB_VID 0xCAFE
+#endif
+
+#ifndef VLP_USB_PID
+#define VLP_USB_PID 0x4010
+#endif
+
+enum
+{
+    ITF_NUM_VENDOR = 0,
+    ITF_NUM_TOTAL
+};
+
+#define EPNUM_VENDOR_OUT 0x01
+#define EPNUM_VENDOR_IN 0x81
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + TUD_VENDOR_DESC_LEN)
+
+static const tusb_desc_device_t desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00, // Defined per interface
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = VLP_USB_VID,
+    .idProduct = VLP_USB_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = 0x01,
+    .iProduct = 0x02,
+    .iSerialNumber = 0x03,
+    .bNumConfigurations = 0x01,
+};
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_NUM_TOTAL, 0, CONFIG_TOTAL_LEN, 0x00, 100),
+    TUD_VENDOR_DESCRIPTOR(ITF_NUM_VENDOR, 4, EPNUM_VENDOR_OUT, EPNUM_VENDOR_IN, VLP_USB_BULK_PACKET_SIZE),
+};
+
+static const char *string_descriptors[] = {
+    NULL, // 0: supported language, handled below
+    "VLP",
+    "VLP-Pico",
+    "000000000001",
+    "VLP bulk",
+};
+
+static uint16_t desc_string[32];
+
+const uint8_t *tud_descriptor_device_cb(void)
+{
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index)
+{
+    (void)index;
+    return desc_configuration;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid)
+{
+    (void)langid;
+
+    size_t chr_count;
+    if (index == 0)
+    {
+        desc_string[1] = 0x0409; // English (United States)
+        chr_count = 1;
+    }
+    else
+    {
+        if (index >= sizeof(string_descriptors) / sizeof(string_descriptors[0]))
+        {
+            return NULL;
+        }
+
+        const char *str = string_descriptors[index];
+        chr_count = strlen(str);
+        if (chr_count > 31)
+        {
+            chr_count = 31;
+        }
+        for (size_t i = 0; i < chr_count; i++)
+        {
+            desc_string[1 + i] = str[i];
+        }
+    }
+
+    // First entry holds the descriptor type and total length in bytes
+    desc_string[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * chr_count + 2));
+    return desc_string;
+}
+
+#endif // VLP_TRANSPORT_USB_VENDOR
@@ -8,6 +8,12 @@
 
 static bool last_led_state = false;
 
+// Non-blocking blink state, advanced by led_task()
+static uint32_t pending_toggles = 0;
+static uint32_t toggle_interval_us = 0;
+static uint64_t next_toggle_us = 0;
+static bool blink_on = false;
+
 void led_init(void)
 {
     gpio_init(LED_PIN);
@@ -34,4 +40,32 @@ void led_blink(uint32_t times, uint32_t interval_ms)
     gpio_put(LED_PIN, last_led_state); // Restore last state
 }
 
+void led_blink_async(uint32_t times, uint32_t interval_ms)
+{
+    pending_toggles = times * 2;
+    toggle_interval_us = interval_ms * 1000 / 2;
+    next_toggle_us = time_us_64();
+    blink_on = false;
+}
+
+bool led_task(uint32_t budget_us)
+{
+    if (pending_toggles == 0)
+    {
+        return false;
+    }
+
+    uint64_t now = time_us_64();
+    if (now < next_toggle_us)
+    {
+        return true;
+    }
+
+    blink_on = !blink_on;
+    pending_toggles--;
+    next_toggle_us = now + toggle_interval_us;
+    gpio_put(LED_PIN, pending_toggles == 0 ? last_led_state : blink_on);
+    return pending_toggles > 0;
+}
+
 #endif
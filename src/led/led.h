@@ -8,4 +8,8 @@ void led_init(void);
 void led_set(bool value);
 void led_blink(uint32_t times, uint32_t interval_ms);
 
+// Same pattern as led_blink() but driven by led_task(), never sleeps
+void led_blink_async(uint32_t times, uint32_t interval_ms);
+bool led_task(uint32_t budget_us);
+
 #endif
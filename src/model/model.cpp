@@ -12,6 +12,8 @@
 #include "tensorflow/lite/micro/system_setup.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
+#include <string.h>
+
 namespace
 {
     const tflite::Model *model = nullptr;
@@ -35,22 +37,38 @@ static inline float fastInvSqrt(float x) {
 }
 
 
-// Normalize a vector of length 'len' in-place using Euclidean norm
-static inline void normalize(float *vec, int len)
+// Reads the i-th little-endian f32 of a frame that may not be 4-byte aligned
+static inline float frame_value(const uint8_t *frame, int i)
+{
+    float value;
+    memcpy(&value, &frame[i * sizeof(float)], sizeof(value));
+    return value;
+}
+
+// Scales, Euclidean-normalizes and quantizes a frame straight into the input
+// tensor. The first pass only accumulates the norm, the second folds the
+// normalization and quantization scale into one multiplier, so no
+// intermediate copy of the frame is made.
+static void quantize_frame(const uint8_t *frame, const float *scalars)
 {
     float norm = 0.0f;
-    for (int i = 0; i < len; i++)
+    for (int i = 0; i < 36; i++)
     {
-        norm += vec[i] * vec[i];
+        float value = frame_value(frame, i) * scalars[i];
+        norm += value * value;
     }
-    float inv_norm = fastInvSqrt(norm);
 
+    float multiplier = 1.0f / input->params.scale;
     if (norm > 0.0f)
     {
-        for (int i = 0; i < len; i++)
-        {
-            vec[i] *= inv_norm;
-        }
+        multiplier *= fastInvSqrt(norm);
+    }
+    float zero_point = static_cast<float>(input->params.zero_point);
+
+    int8_t *quantized = input->data.int8;
+    for (int i = 0; i < 36; i++)
+    {
+        quantized[i] = static_cast<int8_t>(frame_value(frame, i) * scalars[i] * multiplier + zero_point);
     }
 }
 
@@ -83,32 +101,12 @@ TfLiteStatus load_model(void)
     return kTfLiteOk;
 }
 
-// Predict function that takes an array of 36 LED values and outputs the predicted x and y coordinates
-// Will scale the input values using the scalars from the degradation model, normalize them, and then run inference
-// This replaces the LED input with the scaled values from the degradation model as a side effect
-TfLiteStatus predict(float leds[36], float *x, float *y)
+TfLiteStatus predict_frame(const void *frame, float *x, float *y)
 {
     if (!interpreter)
         return kTfLiteError;
 
-    float *scalars = get_scalars();
-
-    float temp_input[36];
-    // Copy the input data to the temp input tensor
-    for (int i = 0; i < 36; i++)
-    {
-        temp_input[i] = leds[i] * scalars[i];
-        leds[i] = temp_input[i];
-    }
-    // Normalize the input data with Euclidean normalization
-    normalize(temp_input, 36);
-
-    // Place the quantized input in the model's input tensor
-    for (int i = 0; i < 36; i++)
-    {
-        input->data.int8[i] = static_cast<int8_t>(
-            (temp_input[i] / input->params.scale) + input->params.zero_point);
-    }
+    quantize_frame(static_cast<const uint8_t *>(frame), get_scalars());
 
     // Run inference
     TF_LITE_ENSURE_STATUS(interpreter->Invoke());
@@ -122,4 +120,12 @@ TfLiteStatus predict(float leds[36], float *x, float *y)
     *y = (y_quantized - output->params.zero_point) * output->params.scale;
 
     return kTfLiteOk;
-}
\ No newline at end of file
+}
+
+size_t model_arena_free_bytes(void)
+{
+    if (!interpreter)
+        return 0;
+
+    return kTensorArenaSize - interpreter->arena_used_bytes();
+}
@@ -3,13 +3,29 @@
 
 #include "tensorflow/lite/core/c/common.h"
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
     TfLiteStatus load_model(void);
-    TfLiteStatus predict(float leds[36], float *x, float *y);
+
+    /**
+     * @brief Runs inference on a frame in its wire encoding.
+     *
+     * The 36 little-endian f32 values are scaled, normalized and quantized
+     * directly into the input tensor, without a float copy of the frame.
+     * Requests pass their rx slot, which already holds the one copy out of
+     * the transport buffer (see parser_feed()).
+     *
+     * @param frame 36 x f32, need not be aligned.
+     * @param x Predicted x coordinate.
+     * @param y Predicted y coordinate.
+     */
+    TfLiteStatus predict_frame(const void *frame, float *x, float *y);
+    size_t model_arena_free_bytes(void);
 
 #ifdef __cplusplus
 }
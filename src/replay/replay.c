@@ -0,0 +1,107 @@
+#include "replay.h"
+
+#include "../model/model.h"
+
+#include "pico/time.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static VlpReplayFrame frames[VLP_REPLAY_FRAMES];
+static float positions[2 * VLP_REPLAY_FRAMES];
+static float errors[VLP_REPLAY_FRAMES];
+static uint16_t last_run = 0; // Frames covered by positions
+
+bool replay_store(uint16_t first, const uint8_t *data, int count)
+{
+    if (first + count > VLP_REPLAY_FRAMES)
+    {
+        return false;
+    }
+
+    memcpy(&frames[first], data, count * sizeof(VlpReplayFrame));
+    return true;
+}
+
+static int compare_floats(const void *a, const void *b)
+{
+    float fa = *(const float *)a;
+    float fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+// Nearest-rank percentile of sorted values
+static float percentile(const float *sorted, int count, int p)
+{
+    int rank = (p * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+bool replay_run(uint16_t count, VlpReplayStats *stats)
+{
+    if (count == 0 || count > VLP_REPLAY_FRAMES)
+    {
+        return false;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->frames = count;
+
+    // Inference only, scoring happens afterwards so elapsed_us is pure model time
+    uint64_t start_us = time_us_64();
+    for (int i = 0; i < count; i++)
+    {
+        float *x = &positions[2 * i];
+        float *y = &positions[2 * i + 1];
+        if (predict_frame(frames[i].leds, x, y) != kTfLiteOk)
+        {
+            *x = NAN;
+            *y = NAN;
+        }
+    }
+    stats->elapsed_us = (uint32_t)(time_us_64() - start_us);
+    last_run = count;
+
+    int scored = 0;
+    float sum = 0.0f;
+    float sum_squares = 0.0f;
+    for (int i = 0; i < count; i++)
+    {
+        float dx = positions[2 * i] - frames[i].x;
+        float dy = positions[2 * i + 1] - frames[i].y;
+        float error = sqrtf(dx * dx + dy * dy);
+        if (isnan(error))
+        {
+            stats->failures++;
+            continue;
+        }
+
+        errors[scored++] = error;
+        sum += error;
+        sum_squares += error * error;
+    }
+
+    if (scored == 0)
+    {
+        return true;
+    }
+
+    qsort(errors, scored, sizeof(errors[0]), compare_floats);
+    stats->mean_error = sum / scored;
+    stats->rms_error = sqrtf(sum_squares / scored);
+    stats->p50_error = percentile(errors, scored, 50);
+    stats->p95_error = percentile(errors, scored, 95);
+    stats->max_error = errors[scored - 1];
+    return true;
+}
+
+const float *replay_positions(uint16_t first, uint16_t count)
+{
+    if (first + count > last_run)
+    {
+        return NULL;
+    }
+
+    return &positions[2 * first];
+}
@@ -0,0 +1,38 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "../io/protocol.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Stores uploaded frames in the replay buffer.
+ *
+ * @param first Index of the first frame, so chunks can be resent or uploaded out of order.
+ * @param frames count packed VlpReplayFrame, need not be aligned.
+ * @param count Number of frames.
+ * @return false if the frames do not fit in VLP_REPLAY_FRAMES.
+ */
+bool replay_store(uint16_t first, const uint8_t *frames, int count);
+
+/**
+ * @brief Runs inference over frames 0..count-1 back to back and scores them.
+ *
+ * Uses the current scalars, like PREDICT. This blocks core0 for the whole
+ * block, requests arriving meanwhile wait in the RX queue.
+ *
+ * @param count Number of frames to run, at most VLP_REPLAY_FRAMES.
+ * @param stats Filled in with the error statistics of the run.
+ * @return false if count is out of range.
+ */
+bool replay_run(uint16_t count, VlpReplayStats *stats);
+
+/**
+ * @brief Returns the predictions of the last run, x and y per frame.
+ *
+ * @return NULL if the range was not covered by the last run.
+ */
+const float *replay_positions(uint16_t first, uint16_t count);
+
+#endif // REPLAY_H
@@ -0,0 +1,221 @@
+#include "scalar_store.h"
+
+#include "../data/lambertian.h"
+#include "../degradation_model/degradation_model.h"
+#include "../io/io.h"
+
+#include "hardware/flash.h"
+#include "pico/flash.h"
+#include "pico/time.h"
+#include <stddef.h>
+#include <string.h>
+
+#define SCALAR_STORE_OFFSET (PICO_FLASH_SIZE_BYTES - SCALAR_STORE_SECTORS * FLASH_SECTOR_SIZE)
+#define SCALAR_STORE_SLOTS (SCALAR_STORE_SECTORS * FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define SLOTS_PER_SECTOR (FLASH_SECTOR_SIZE / FLASH_PAGE_SIZE)
+#define SCALAR_STORE_MAGIC 0x53504C56 // "VLPS"
+#define FLASH_TIMEOUT_MS 100
+
+typedef struct ScalarRecord
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;     // sizeof(ScalarRecord) when written
+    uint32_t sequence; // Newest record wins
+    float scalars[TX_POSITIONS_COUNT];
+    uint32_t crc; // CRC-32 of every field above
+} ScalarRecord;
+
+_Static_assert(sizeof(ScalarRecord) <= FLASH_PAGE_SIZE, "A record must fit a flash page");
+
+static float stored_scalars[TX_POSITIONS_COUNT]; // Scalars of the newest checkpoint
+static uint32_t next_sequence = 0;
+static int next_slot = 0;
+static int spare_sector = -1; // Sector erased ahead of the ring, -1 if none
+static absolute_time_t next_write_time;
+
+// Page handed to flash_range_program(), also read by the flash callbacks
+static uint8_t page[FLASH_PAGE_SIZE];
+static uint32_t flash_offset;
+
+static uint32_t crc32(const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t slot_offset(int slot)
+{
+    return SCALAR_STORE_OFFSET + slot * FLASH_PAGE_SIZE;
+}
+
+static const ScalarRecord *slot_record(int slot)
+{
+    return (const ScalarRecord *)(XIP_BASE + slot_offset(slot));
+}
+
+static bool record_valid(const ScalarRecord *record)
+{
+    return record->magic == SCALAR_STORE_MAGIC && record->version == SCALAR_STORE_VERSION &&
+           record->size == sizeof(ScalarRecord) && record->crc == crc32(record, offsetof(ScalarRecord, crc));
+}
+
+static bool slot_blank(int slot)
+{
+    const uint8_t *bytes = (const uint8_t *)slot_record(slot);
+    for (int i = 0; i < FLASH_PAGE_SIZE; i++)
+    {
+        if (bytes[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int sector_of(int slot)
+{
+    return slot / SLOTS_PER_SECTOR;
+}
+
+// Sector the ring moves into next, erasing it never touches the newest record
+static int ahead_sector()
+{
+    return next_slot % SLOTS_PER_SECTOR == 0 ? sector_of(next_slot)
+                                              : (sector_of(next_slot) + 1) % SCALAR_STORE_SECTORS;
+}
+
+static bool sector_blank(int sector)
+{
+    for (int slot = sector * SLOTS_PER_SECTOR; slot < (sector + 1) * SLOTS_PER_SECTOR; slot++)
+    {
+        if (!slot_blank(slot))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void erase_sector(void *param)
+{
+    flash_range_erase(flash_offset, FLASH_SECTOR_SIZE);
+}
+
+static void program_page(void *param)
+{
+    flash_range_program(flash_offset, page, FLASH_PAGE_SIZE);
+}
+
+bool scalar_store_restore(void)
+{
+    int newest = -1;
+    for (int slot = 0; slot < SCALAR_STORE_SLOTS; slot++)
+    {
+        const ScalarRecord *record = slot_record(slot);
+        if (record_valid(record) && (newest < 0 || record->sequence > slot_record(newest)->sequence))
+        {
+            newest = slot;
+        }
+    }
+
+    next_write_time = make_timeout_time_ms(SCALAR_STORE_INTERVAL_MS);
+    next_slot = newest < 0 ? 0 : (newest + 1) % SCALAR_STORE_SLOTS;
+
+    // A sector that is already blank, e.g. fresh flash, needs no erase
+    int ahead = ahead_sector();
+    spare_sector = sector_blank(ahead) ? ahead : -1;
+
+    if (newest < 0)
+    {
+        memcpy(stored_scalars, get_scalars(), sizeof(stored_scalars));
+        return false;
+    }
+
+    const ScalarRecord *record = slot_record(newest);
+    memcpy(stored_scalars, record->scalars, sizeof(stored_scalars));
+    next_sequence = record->sequence + 1;
+    set_scalars(stored_scalars);
+    return true;
+}
+
+static bool link_quiet()
+{
+    return time_us_64() - io_last_rx_us() >= (uint64_t)SCALAR_STORE_QUIET_MS * 1000;
+}
+
+bool scalar_store_task(uint32_t budget_us)
+{
+    // Erasing stalls both cores for tens of ms, so it is done ahead of time
+    // and only once the host has been silent for a while
+    int ahead = ahead_sector();
+    if (spare_sector != ahead && link_quiet())
+    {
+        flash_offset = ahead * FLASH_SECTOR_SIZE + SCALAR_STORE_OFFSET;
+        if (flash_safe_execute(erase_sector, NULL, FLASH_TIMEOUT_MS) != PICO_OK)
+        {
+            return true; // Core1 did not park in time, try again next turn
+        }
+        spare_sector = ahead;
+        return true; // At most one stall per turn
+    }
+
+    const float *scalars = get_scalars();
+    if (memcmp(scalars, stored_scalars, sizeof(stored_scalars)) == 0 ||
+        absolute_time_diff_us(get_absolute_time(), next_write_time) > 0)
+    {
+        return false;
+    }
+
+    // A torn or stale page mid-sector means moving on to the next sector
+    if (next_slot % SLOTS_PER_SECTOR != 0 && !slot_blank(next_slot))
+    {
+        if (spare_sector != ahead)
+        {
+            return false;
+        }
+        next_slot = ahead * SLOTS_PER_SECTOR;
+    }
+
+    // Entering a sector needs the spare, the checkpoint waits for a quiet link otherwise
+    if (next_slot % SLOTS_PER_SECTOR == 0 && spare_sector != sector_of(next_slot))
+    {
+        return false;
+    }
+
+    ScalarRecord record = {
+        .magic = SCALAR_STORE_MAGIC,
+        .version = SCALAR_STORE_VERSION,
+        .size = sizeof(ScalarRecord),
+        .sequence = next_sequence,
+    };
+    memcpy(record.scalars, scalars, sizeof(record.scalars));
+    record.crc = crc32(&record, offsetof(ScalarRecord, crc));
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &record, sizeof(record));
+    flash_offset = slot_offset(next_slot);
+    if (flash_safe_execute(program_page, NULL, FLASH_TIMEOUT_MS) != PICO_OK)
+    {
+        return true;
+    }
+
+    if (spare_sector == sector_of(next_slot))
+    {
+        spare_sector = -1; // In use now, the other sector becomes the next spare
+    }
+    memcpy(stored_scalars, record.scalars, sizeof(stored_scalars));
+    next_sequence++;
+    next_slot = (next_slot + 1) % SCALAR_STORE_SLOTS;
+    next_write_time = make_timeout_time_ms(SCALAR_STORE_INTERVAL_MS);
+    return false;
+}
@@ -0,0 +1,52 @@
+#ifndef SCALAR_STORE_H
+#define SCALAR_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Checkpoints of the degradation scalars are appended, one flash page each,
+// to the last SCALAR_STORE_SECTORS sectors. A sector is only erased once the
+// ring reaches it again, and never while it holds the newest checkpoint.
+#define SCALAR_STORE_SECTORS 2
+#define SCALAR_STORE_VERSION 1 // Bump when the record layout changes, older records are ignored
+
+#ifndef SCALAR_STORE_INTERVAL_MS
+#define SCALAR_STORE_INTERVAL_MS 60000 // Minimum time between checkpoints, bounds flash wear
+#endif
+
+#define SCALAR_STORE_QUIET_MS 1000 // Host silence required before a sector is erased
+
+/**
+ * @brief Finds the newest valid checkpoint and applies it with set_scalars().
+ *
+ * Call from main() after degradation_model_init() and before the first
+ * prediction. Records with a bad CRC or another version are skipped.
+ *
+ * @return true if scalars were restored, false if the device starts from the defaults.
+ */
+bool scalar_store_restore(void);
+
+/**
+ * @brief Background task writing a checkpoint once the scalars changed.
+ *
+ * At most one checkpoint per SCALAR_STORE_INTERVAL_MS. Flash cannot be read
+ * while it is written, so every flash operation runs through
+ * flash_safe_execute() with core1 locked out, and core1 must have called
+ * flash_safe_execute_core_init(). A page program stalls both cores for about
+ * 1 ms and only runs while no request is waiting. A sector erase stalls them
+ * for 50 to 400 ms, so the next sector is erased ahead of time and only after
+ * SCALAR_STORE_QUIET_MS without a byte from the host. A checkpoint that needs
+ * a fresh sector before one could be erased waits for a quiet link.
+ */
+bool scalar_store_task(uint32_t budget_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SCALAR_STORE_H
@@ -0,0 +1,131 @@
+#include "telemetry.h"
+
+#include "../degradation_model/degradation_model.h"
+#include "../event_loop/event_loop.h"
+#include "../io/io.h"
+#include "../io/tx_queue.h"
+#include "../model/model.h"
+
+#include "pico/time.h"
+
+#include <string.h>
+
+#define STACK_PAINT 0xA5A5A5A5u
+
+// Core0 stack bounds from the linker script
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+
+static uint32_t counters[TELEMETRY_COUNTER_COUNT];
+static uint32_t histograms[VLP_HISTOGRAM_COUNT][VLP_TELEMETRY_BUCKETS];
+static uint32_t period_ms = TELEMETRY_PERIOD_MS;
+static uint64_t next_report_us = 0;
+
+// Fills the unused part of the stack so the deepest use can be found later
+static void paint_stack(void)
+{
+    uint32_t *p = &__StackBottom;
+    uint32_t *live = (uint32_t *)__builtin_frame_address(0) - 16; // Stay clear of this frame
+    while (p < live)
+    {
+        *p++ = STACK_PAINT;
+    }
+}
+
+static uint32_t stack_free_bytes(void)
+{
+    uint32_t *p = &__StackBottom;
+    while (p < &__StackTop && *p == STACK_PAINT)
+    {
+        p++;
+    }
+    return (uint32_t)((uintptr_t)p - (uintptr_t)&__StackBottom);
+}
+
+static inline int bucket_for(uint32_t duration_us)
+{
+    int bucket = duration_us == 0 ? 0 : 32 - __builtin_clz(duration_us);
+    return bucket < VLP_TELEMETRY_BUCKETS ? bucket : VLP_TELEMETRY_BUCKETS - 1;
+}
+
+void telemetry_init(void)
+{
+    memset(counters, 0, sizeof(counters));
+    memset(histograms, 0, sizeof(histograms));
+    next_report_us = time_us_64() + (uint64_t)period_ms * 1000;
+    paint_stack();
+}
+
+void telemetry_count(TelemetryCounter counter)
+{
+    counters[counter]++;
+}
+
+void telemetry_record(VlpTelemetryHistogram histogram, uint32_t duration_us)
+{
+    histograms[histogram][bucket_for(duration_us)]++;
+}
+
+void telemetry_snapshot(VlpTelemetryReport *report)
+{
+    EventLoopStats loop_stats;
+    event_loop_get_stats(&loop_stats);
+    TxQueueStats tx_stats;
+    tx_queue_get_stats(&tx_stats);
+
+    report->uptime_ms = (uint32_t)(time_us_64() / 1000);
+    report->packets_received = counters[TELEMETRY_PACKETS_RECEIVED];
+    report->packets_answered = counters[TELEMETRY_PACKETS_ANSWERED];
+    report->parse_errors = counters[TELEMETRY_PARSE_ERRORS];
+    report->timeouts = counters[TELEMETRY_TIMEOUTS];
+    memcpy(report->histograms, histograms, sizeof(report->histograms));
+    report->max_packet_latency_us = loop_stats.max_packet_latency_us;
+    report->max_background_slice_us = loop_stats.max_background_slice_us;
+    report->rx_pending = (uint16_t)io_pending_requests();
+    report->tx_pending = (uint16_t)tx_queue_pending();
+    report->tx_high_water_mark = tx_stats.high_water_mark;
+    report->tx_dropped_frames = tx_stats.dropped_frames;
+    report->arena_free_bytes = (uint32_t)model_arena_free_bytes();
+    report->stack_free_bytes = stack_free_bytes();
+    report->dropped_oldest = counters[TELEMETRY_DROPPED_OLDEST];
+    report->dropped_newest = counters[TELEMETRY_DROPPED_NEWEST];
+    report->coalesced = counters[TELEMETRY_COALESCED];
+
+    LedFitStats fit_stats;
+    get_led_fit_stats(&fit_stats);
+    memcpy(report->fit_iterations, fit_stats.iterations, sizeof(report->fit_iterations));
+    memcpy(report->fit_us, fit_stats.fit_us, sizeof(report->fit_us));
+}
+
+bool telemetry_send(const IncomingPacket *request)
+{
+    VlpTelemetryReport report;
+    telemetry_snapshot(&report);
+    if (!request)
+    {
+        return write_packet(VLP_RESPONSE_TELEMETRY, 0, &report, sizeof(report));
+    }
+    return write_reply(request, VLP_RESPONSE_TELEMETRY, &report, sizeof(report));
+}
+
+void telemetry_set_period_ms(uint32_t new_period_ms)
+{
+    period_ms = new_period_ms;
+    next_report_us = time_us_64() + (uint64_t)period_ms * 1000;
+}
+
+void telemetry_tick(void)
+{
+    if (period_ms == 0)
+    {
+        return;
+    }
+
+    uint64_t now = time_us_64();
+    if (now < next_report_us)
+    {
+        return;
+    }
+    next_report_us = now + (uint64_t)period_ms * 1000;
+    telemetry_send(NULL);
+}
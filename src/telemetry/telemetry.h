@@ -0,0 +1,82 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "../io/io.h"
+#include "../io/protocol.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifndef TELEMETRY_PERIOD_MS
+#define TELEMETRY_PERIOD_MS 5000 // Default unsolicited report interval, 0 disables it
+#endif
+
+typedef enum TelemetryCounter
+{
+    TELEMETRY_PACKETS_RECEIVED,
+    TELEMETRY_PACKETS_ANSWERED,
+    TELEMETRY_PARSE_ERRORS,
+    TELEMETRY_TIMEOUTS,
+    TELEMETRY_DROPPED_OLDEST,
+    TELEMETRY_DROPPED_NEWEST,
+    TELEMETRY_COALESCED,
+    TELEMETRY_COUNTER_COUNT,
+} TelemetryCounter;
+
+/**
+ * @brief Clears all counters and marks the core0 stack for headroom tracking.
+ *
+ * Must be called from main() on core0 before anything deep is on the stack.
+ */
+void telemetry_init(void);
+
+/**
+ * @brief Increments a counter. Counters are only updated from core0.
+ */
+void telemetry_count(TelemetryCounter counter);
+
+/**
+ * @brief Adds a duration to a histogram.
+ *
+ * Each histogram has a single writer core, see VlpTelemetryHistogram.
+ *
+ * @param histogram The histogram to update.
+ * @param duration_us The measured duration in microseconds.
+ */
+void telemetry_record(VlpTelemetryHistogram histogram, uint32_t duration_us);
+
+/**
+ * @brief Fills in a report with the current state of the device.
+ */
+void telemetry_snapshot(VlpTelemetryReport *report);
+
+/**
+ * @brief Queues a report for the host.
+ *
+ * @param request The request asking for it, NULL for an unsolicited report.
+ * @return false if the TX queue had no room for the report.
+ */
+bool telemetry_send(const IncomingPacket *request);
+
+/**
+ * @brief Changes the unsolicited report interval, 0 disables it.
+ */
+void telemetry_set_period_ms(uint32_t period_ms);
+
+/**
+ * @brief Sends an unsolicited report once every report interval.
+ *
+ * Meant to be hooked to the event loop's timer tick.
+ */
+void telemetry_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
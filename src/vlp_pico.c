@@ -2,70 +2,71 @@
 #include <string.h>
 
 #include "pico/stdlib.h"
-#include "pico/stdio_usb.h"
+#include "pico/multicore.h"
+#include "pico/flash.h"
 
 #include "model/model.h"
 #include "io/io.h"
+#include "commands/commands.h"
 #include "debug.h"
 
 #include "data/data.h"
 
 #include "degradation_model/degradation_model.h"
+#include "event_loop/event_loop.h"
+#include "scalar_store/scalar_store.h"
+#include "telemetry/telemetry.h"
+
+#define MAIN_TICK_INTERVAL_US 10000
+
+// Core1 drains the transmit queue so the inference loop never waits on the host,
+// and runs recalibrations one LED at a time in between
+static void core1_entry(void)
+{
+    flash_safe_execute_core_init(); // Parks core1 in RAM while core0 writes a checkpoint
+
+    while (true)
+    {
+        bool sent = io_tx_task() > 0;
+        bool fitted = recalibrate_step();
+        if (!sent && !fitted)
+        {
+            tight_loop_contents();
+        }
+    }
+}
 
 int main()
 {
+    telemetry_init();
     io_init();
+    degradation_model_init();
+    scalar_store_restore(); // Warm start from the last checkpoint before anything is predicted
     DEBUG_LED_INIT();
+    multicore_launch_core1(core1_entry);
 
     if (load_model() != kTfLiteOk)
     {
         return 1;
     }
 
-    while (!stdio_usb_connected())
+    while (!io_connected())
     {
-        sleep_ms(100); // Wait for USB connection
+        sleep_ms(100); // Wait for the host link
     }
 
     // Indicate that the program is running
     DEBUG_LED_SET(true);
 
-    while (true)
-    {
-        // sleep_ms(1); // Sleep to avoid busy-waiting
-
-        // Read a packet with a timeout
-        IncomingPacket packet;
-        int result = read_packet(100, &packet);
-        if (result == PICO_ERROR_TIMEOUT)
-        {
-            continue;
-        }
-
-        float x, y;
-        if (predict(packet.leds, &x, &y) != kTfLiteOk)
-        {
-            continue;
-        }
-
-        DEBUG_LED_BLINK(5, 100);
-
-        if (packet.eval)
-        {
-            write_packet(x, y);
-            continue;
-        }
-
-        // If not evaluating, do led degradation logic
-        bool updated = add_sample(packet.leds, x, y);
-
-        if (updated) {
-            for (int i = 0; i < 18; i++)
-            {
-                write_packet(get_scalars()[i * 2], get_scalars()[i * 2 + 1]); // Send pairs of scalars
-            }
-        }
-    }
+    event_loop_init(MAIN_TICK_INTERVAL_US);
+    event_loop_on(EVENT_PACKET_READY, commands_handle_next);
+    event_loop_on(EVENT_TIMER_TICK, telemetry_tick);
+    event_loop_add_task(commands_recalibration_task);
+    event_loop_add_task(scalar_store_task);
+#ifdef DEBUG_LED
+    event_loop_add_task(led_task);
+#endif
+    event_loop_run();
 
     return 0;
 }